@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    CachedLayer.h
+    Created: 19 Oct 2026 9:27:05pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#define PAINT_TIMER_SMOOTHING 0.1 // how much each frame moves the running mean
+#define PAINT_TIMER_WORST_FRAMES 60 // the worst frame is forgotten after this many frames
+#define PAINT_MAX_FRAME_SHARE 0.5 // frames are skipped to keep painting to at most this share of the frame interval
+
+#include <JuceHeader.h>
+
+
+/**
+ @brief A part of a component's drawing which is rendered once into an image and then just copied, until something it depends on changes.
+
+ The caller sums up everything the layer depends on in a key, such as a hash of the tap times. The layer is re-rendered when the key, its area or the display's scale changes, and copied otherwise. Images are rendered at the physical pixel scale, so a cached layer looks the same as drawing directly.
+ */
+class CachedLayer
+{
+public:
+
+    /**
+     @brief Draws the layer at area, first re-rendering it if anything has changed since it was last rendered.
+
+     @param g The context to draw into.
+     @param area Where the layer goes, in the component's coordinates.
+     @param key A summary of everything the layer depends on.
+     @param render Called with a context whose origin is the top left of area to render the layer, as `render(Graphics&, Rectangle<int> localArea)`.
+     */
+    template <class RenderFunction>
+    void draw(Graphics& g, Rectangle<int> area, uint64 key, RenderFunction&& render)
+    {
+        if (area.isEmpty()) return;
+
+        const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+        if (! image.isValid() || area.getWidth() != cachedArea.getWidth() || area.getHeight() != cachedArea.getHeight() || scale != cachedScale || key != cachedKey)
+        {
+            image = Image(Image::ARGB, jmax(1, roundToInt(area.getWidth() * scale)), jmax(1, roundToInt(area.getHeight() * scale)), true);
+
+            Graphics ig(image);
+            ig.addTransform(AffineTransform::scale(scale));
+            render(ig, area.withZeroOrigin());
+
+            cachedArea = area;
+            cachedScale = scale;
+            cachedKey = key;
+        }
+
+        g.drawImage(image, area.toFloat());
+    }
+
+    /// @brief Forces the layer to be re-rendered next time it is drawn, for changes the key doesn't cover, such as a colour scheme.
+    void invalidate() { image = Image(); }
+
+private:
+    Image image;
+    Rectangle<int> cachedArea;
+    float cachedScale = 0.0f;
+    uint64 cachedKey = 0;
+};
+
+
+/**
+ @brief Measures how long a component's paint() calls take.
+
+ Keeps a running mean and the worst of the last PAINT_TIMER_WORST_FRAMES frames, and caps the frame rate of components whose frames turn out to be expensive. Message thread only.
+ */
+class PaintTimer
+{
+public:
+
+    /// Times one paint() call, from construction to destruction.
+    class ScopedMeasurement
+    {
+    public:
+        ScopedMeasurement(PaintTimer& _timer) : timer(_timer), startTicks(Time::getHighResolutionTicks()) {}
+        ~ScopedMeasurement() { timer.addFrame(Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks) * 1000.0); }
+
+    private:
+        PaintTimer& timer;
+        const int64 startTicks;
+    };
+
+    /**
+     @brief Starts timing a frame, for components whose frame spans more than one call, such as paint() through to paintOverChildren(). Ended by endFrame().
+     */
+    void startFrame() { frameStartTicks = Time::getHighResolutionTicks(); }
+
+    /// @brief Ends a frame started by startFrame().
+    void endFrame() { addFrame(Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - frameStartTicks) * 1000.0); }
+
+    /// @brief Gets the running mean paint time, in milliseconds.
+    double getMeanMs() const { return meanMs; }
+
+    /// @brief Gets the longest recent paint time, in milliseconds.
+    double getWorstMs() const { return worstMs; }
+
+    /// @brief Gets the duration of the most recent frame, in milliseconds.
+    double getLastMs() const { return lastMs; }
+
+    /**
+     @brief Call on every tick of a component's frame timer, before asking for a repaint. Returns true if the tick should be skipped.
+
+     Ticks are skipped so that, on average, painting takes no more than PAINT_MAX_FRAME_SHARE of the time between ticks, which leaves the message thread free for the host however slow the component is to paint.
+
+     @param frameIntervalMs The time between ticks, in milliseconds.
+     */
+    bool shouldSkipFrame(double frameIntervalMs)
+    {
+        if (framesToSkip > 0)
+        {
+            --framesToSkip;
+            return true;
+        }
+
+        framesToSkip = jmax(0, (int) std::ceil(meanMs / (frameIntervalMs * PAINT_MAX_FRAME_SHARE)) - 1);
+        return false;
+    }
+
+private:
+    void addFrame(double ms)
+    {
+        lastMs = ms;
+        meanMs = (numFrames == 0) ? ms : meanMs + (ms - meanMs) * PAINT_TIMER_SMOOTHING;
+
+        if (++numFrames % PAINT_TIMER_WORST_FRAMES == 0) worstMs = ms;
+        else worstMs = jmax(worstMs, ms);
+    }
+
+    double lastMs = 0.0, meanMs = 0.0, worstMs = 0.0;
+    int64 numFrames = 0;
+    int framesToSkip = 0;
+    int64 frameStartTicks = 0;
+};
@@ -12,35 +12,42 @@
 #include "DlyTapComponent.h"
 
 //==============================================================================
-DlyTapComponent::DlyTapComponent()
+DlyTapComponent::DlyTapComponent(double _timeMs) : timeMs(_timeMs)
 {
-    // In your constructor, you should add any child components, and
-    // initialise any special settings that your component needs.
-
+    // the TapEditorComponent finds taps through its own index, which is far quicker than asking every child
+    setInterceptsMouseClicks(false, false);
 }
 
 DlyTapComponent::~DlyTapComponent()
 {
 }
 
-void DlyTapComponent::paint (juce::Graphics& g)
+void DlyTapComponent::setSelected(bool shouldBeSelected)
 {
-    /* This demo code just fills the component's background and
-       draws some placeholder text to get you started.
+    if (selected == shouldBeSelected) return;
 
-       You should replace everything in this method with your own
-       drawing code..
-    */
+    selected = shouldBeSelected;
+    repaint();
+}
 
-    g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));   // clear the background
+void DlyTapComponent::setFocused(bool shouldBeFocused)
+{
+    if (focused == shouldBeFocused) return;
 
-    g.setColour (juce::Colours::grey);
-    g.drawRect (getLocalBounds(), 1);   // draw an outline around the component
+    focused = shouldBeFocused;
+    repaint();
+}
 
-    g.setColour (juce::Colours::white);
-    g.setFont (14.0f);
-    g.drawText ("DlyTapComponent", getLocalBounds(),
-                juce::Justification::centred, true);   // draw some placeholder text
+void DlyTapComponent::paint (juce::Graphics& g)
+{
+    g.setColour (selected ? juce::Colours::orange : juce::Colours::grey);
+    g.fillRect (getLocalBounds().reduced(getWidth() / 4, 0));
+
+    if (focused)
+    {
+        g.setColour (juce::Colours::white);
+        g.drawRect (getLocalBounds(), 1);
+    }
 }
 
 void DlyTapComponent::resized()
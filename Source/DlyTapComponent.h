@@ -10,27 +10,49 @@
 
 #pragma once
 
+#define DLY_TAP_COMPONENT_WIDTH 8
+
 #include <JuceHeader.h>
 //#include "MultiDlyTap.h"
 #include "multiDlyEngine.h"
 
 //==============================================================================
 /*
+ A single tap in the TapEditorComponent, drawn as a handle at the tap's time. The editor owns it and does its hit testing, so it never takes mouse clicks itself.
 */
 class DlyTapComponent  : public juce::Component
 {
 public:
-    DlyTapComponent();
-    DlyTapComponent(DlyTapComponent& other);
+    DlyTapComponent(double _timeMs);
     ~DlyTapComponent() override;
 
     void paint (juce::Graphics&) override;
     void resized() override;
 
+    /// Gets the tap's time, in milliseconds.
+    double getTimeMs() const { return timeMs; }
+
+    /// Sets the tap's time, in milliseconds. This doesn't move the component; the editor lays it out from the time.
+    void setTimeMs(double newTimeMs) { timeMs = newTimeMs; }
+
+    void setSelected(bool shouldBeSelected);
+    bool isSelected() const { return selected; }
+
+    void setFocused(bool shouldBeFocused);
+    bool isFocused() const { return focused; }
+
+    /// Gets the host slot of the engine tap this stands for, or -1 if it isn't linked to one. See MultiDlyTap::getHostSlot().
+    int getHostSlot() const { return hostSlot; }
+
+    /// Links this to the engine tap with a host slot, whose host parameters the editor then changes when this is dragged.
+    void setHostSlot(int newHostSlot) { hostSlot = newHostSlot; }
+
 private:
 
-  int linkedTapIdx;
+    int hostSlot = -1;
 
+    double timeMs;
+    bool selected = false, focused = false;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DlyTapComponent)
 };
@@ -0,0 +1,26 @@
+/*
+  ==============================================================================
+
+    MultiDlyBackgroundThread.h
+    Created: 19 Oct 2026 2:18:40pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+/**
+ @brief The single low-priority thread every engine in the process uses for work which must stay off the audio thread, such as committing delay buffer memory and building impulse responses.
+
+ Hold it through a `juce::SharedResourcePointer`, like MultiDlyWorkerPool, so that a session with a hundred instances still only has one. Work is done by registering a `TimeSliceClient`.
+ */
+class MultiDlyBackgroundThread : public TimeSliceThread
+{
+public:
+    MultiDlyBackgroundThread() : TimeSliceThread("MultiDly background") { startThread(3); }
+    ~MultiDlyBackgroundThread() override { stopThread(1000); }
+};
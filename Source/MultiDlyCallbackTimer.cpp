@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    MultiDlyCallbackTimer.cpp
+    Created: 19 Oct 2026 5:20:14pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#include "MultiDlyCallbackTimer.h"
+
+
+MultiDlyCallbackTimer::ScopedMeasurement::ScopedMeasurement(MultiDlyCallbackTimer& _timer, int _numSamples, double _sampleRate) noexcept
+    : timer(_timer), numSamples(_numSamples), sampleRate(_sampleRate), startTicks(Time::getHighResolutionTicks())
+{
+}
+
+MultiDlyCallbackTimer::ScopedMeasurement::~ScopedMeasurement() noexcept
+{
+    timer.record(Time::getHighResolutionTicks() - startTicks, numSamples, sampleRate);
+}
+
+
+MultiDlyCallbackTimer::MultiDlyCallbackTimer() : ticksPerSecond((double) Time::getHighResolutionTicksPerSecond())
+{
+}
+
+
+void MultiDlyCallbackTimer::record(int64 elapsedTicks, int numSamples, double sampleRate) noexcept
+{
+    if (numSamples <= 0 || sampleRate <= 0.0) return;
+
+    const double budgetTicks = numSamples / sampleRate * ticksPerSecond;
+    const double load = elapsedTicks / budgetTicks;
+
+    const int bin = jlimit(0, CALLBACK_TIMING_BINS - 1, (int) (load * CALLBACK_TIMING_BINS_PER_BUDGET));
+    bins[bin].fetch_add(1, std::memory_order_relaxed);
+
+    numCallbacks.fetch_add(1, std::memory_order_relaxed);
+    if (load >= 1.0) numDeadlineMisses.fetch_add(1, std::memory_order_relaxed);
+
+    totalLoad.store(totalLoad.load(std::memory_order_relaxed) + load, std::memory_order_relaxed);
+    if (load > worstLoad.load(std::memory_order_relaxed)) worstLoad.store(load, std::memory_order_relaxed);
+}
+
+
+double MultiDlyCallbackTimer::getPercentile(double fraction, int64 total) const
+{
+    const auto target = (int64) std::ceil(fraction * total);
+    int64 seen = 0;
+
+    for (int bin = 0; bin < CALLBACK_TIMING_BINS; ++bin)
+    {
+        seen += bins[bin].load(std::memory_order_relaxed);
+
+        // the top of the bin, so a percentile is never under-reported
+        if (seen >= target) return (double) (bin + 1) / CALLBACK_TIMING_BINS_PER_BUDGET;
+    }
+
+    return (double) CALLBACK_TIMING_BINS / CALLBACK_TIMING_BINS_PER_BUDGET;
+}
+
+
+MultiDlyCallbackTimer::Stats MultiDlyCallbackTimer::getStats() const
+{
+    Stats s;
+    s.numCallbacks = numCallbacks.load(std::memory_order_relaxed);
+    s.numDeadlineMisses = numDeadlineMisses.load(std::memory_order_relaxed);
+    s.worstLoad = worstLoad.load(std::memory_order_relaxed);
+
+    if (s.numCallbacks > 0)
+    {
+        s.meanLoad = totalLoad.load(std::memory_order_relaxed) / s.numCallbacks;
+        s.p50Load = getPercentile(0.5, s.numCallbacks);
+        s.p99Load = jmin(getPercentile(0.99, s.numCallbacks), s.worstLoad); // the worst load is exact, so never report more than it
+    }
+
+    return s;
+}
+
+
+void MultiDlyCallbackTimer::reset() noexcept
+{
+    for (auto& b : bins) b.store(0, std::memory_order_relaxed);
+
+    numCallbacks.store(0, std::memory_order_relaxed);
+    numDeadlineMisses.store(0, std::memory_order_relaxed);
+    totalLoad.store(0.0, std::memory_order_relaxed);
+    worstLoad.store(0.0, std::memory_order_relaxed);
+}
+
+
+String MultiDlyCallbackTimer::toString() const
+{
+    const Stats s = getStats();
+
+    return "callbacks " + String(s.numCallbacks)
+         + ", mean " + String(s.meanLoad * 100.0, 1) + "%"
+         + ", p50 " + String(s.p50Load * 100.0, 0) + "%"
+         + ", p99 " + String(s.p99Load * 100.0, 0) + "%"
+         + ", worst " + String(s.worstLoad * 100.0, 1) + "%"
+         + ", deadline misses " + String(s.numDeadlineMisses);
+}
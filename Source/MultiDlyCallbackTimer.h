@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    MultiDlyCallbackTimer.h
+    Created: 19 Oct 2026 5:20:14pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifndef MULTIDLY_CALLBACK_TIMING
+ #define MULTIDLY_CALLBACK_TIMING 0 // set by the MULTIDLY_CALLBACK_TIMING CMake option
+#endif
+
+#define CALLBACK_TIMING_BINS 200 // each bin is 1% of a callback's budget, so the histogram covers up to twice the budget
+#define CALLBACK_TIMING_BINS_PER_BUDGET 100
+
+#include <JuceHeader.h>
+
+
+/**
+ @brief A lock-free record of how much of its realtime budget each audio callback used.
+
+ A callback's budget is the duration of the audio it produces, so a load of 1.0 means the callback took exactly as long as the block lasts, and anything from there on is a deadline miss. Loads are kept in a histogram of CALLBACK_TIMING_BINS bins of 1% each, with everything beyond the last bin counted in it, and the worst load seen is kept exactly.
+
+ record() is called once per callback on the audio thread and is a handful of relaxed atomic operations. Everything else is for the editor or a headless tool, and can be called from any thread while audio is running. A snapshot may be very slightly inconsistent, for instance counting a callback in the total but not yet in its bin, which is fine for a statistic.
+ */
+class MultiDlyCallbackTimer
+{
+public:
+
+    /// Everything the timer knows, as read by getStats(). Loads are fractions of the budget.
+    struct Stats
+    {
+        int64 numCallbacks = 0;
+        int64 numDeadlineMisses = 0;
+        double meanLoad = 0.0;
+        double p50Load = 0.0;
+        double p99Load = 0.0;
+        double worstLoad = 0.0;
+    };
+
+    /// Times one callback, from construction to destruction, into a timer.
+    class ScopedMeasurement
+    {
+    public:
+        ScopedMeasurement(MultiDlyCallbackTimer& _timer, int _numSamples, double _sampleRate) noexcept;
+        ~ScopedMeasurement() noexcept;
+
+    private:
+        MultiDlyCallbackTimer& timer;
+        const int numSamples;
+        const double sampleRate;
+        const int64 startTicks;
+    };
+
+
+    /// Constructor.
+    MultiDlyCallbackTimer();
+
+    /**
+     @brief Records one callback. Never allocates or blocks.
+
+     @param elapsedTicks How long the callback took, in `juce::Time::getHighResolutionTicks()`.
+     @param numSamples The number of samples the callback produced.
+     @param sampleRate The sampling rate, in Hz.
+     */
+    void record(int64 elapsedTicks, int numSamples, double sampleRate) noexcept;
+
+    /// @brief Gets the current statistics, including percentiles worked out from the histogram.
+    Stats getStats() const;
+
+    /// @brief Clears every count. Callbacks recorded while this runs may be partly kept.
+    void reset() noexcept;
+
+    /// @brief Gets the statistics as a single line of text, for logging and headless tools.
+    String toString() const;
+
+private:
+
+    /// Gets the load at which a given fraction of the recorded callbacks were at or below.
+    double getPercentile(double fraction, int64 total) const;
+
+    const double ticksPerSecond;
+
+    std::array<std::atomic<uint32>, CALLBACK_TIMING_BINS> bins {};
+    std::atomic<int64> numCallbacks { 0 }, numDeadlineMisses { 0 };
+    std::atomic<double> totalLoad { 0.0 }; // only ever written by the audio thread, so a plain load and store is enough
+    std::atomic<double> worstLoad { 0.0 }; // likewise
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiDlyCallbackTimer)
+};
+
+
+#if MULTIDLY_CALLBACK_TIMING
+ #define MULTIDLY_TIME_CALLBACK(timer, numSamples, sampleRate) MultiDlyCallbackTimer::ScopedMeasurement multiDlyCallbackMeasurement(timer, numSamples, sampleRate);
+#else
+ #define MULTIDLY_TIME_CALLBACK(timer, numSamples, sampleRate)
+#endif
@@ -0,0 +1,494 @@
+/*
+  ==============================================================================
+
+    MultiDlyDelayBuffer.cpp
+    Created: 19 Oct 2026 11:40:27am
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#include "MultiDlyDelayBuffer.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+
+ #if JUCE_MSVC
+  #include <intrin.h>
+  #define MULTIDLY_F16C_TARGET
+ #else
+  #include <cpuid.h>
+  #define MULTIDLY_F16C_TARGET __attribute__((target("avx,f16c")))
+ #endif
+
+/**
+ Whether the CPU has the F16C half precision conversions, and the OS saves the AVX registers they use. Checked once.
+
+ The plugin isn't built for any particular CPU, so the F16C code is compiled for it with a target attribute and only
+ called when this says it's safe.
+ */
+static bool cpuHasF16C() noexcept
+{
+    static const bool result = []
+    {
+        unsigned int c = 0;
+
+       #if JUCE_MSVC
+        int info[4];
+        __cpuid(info, 1);
+        c = (unsigned int) info[2];
+       #else
+        unsigned int a, b, d;
+        if (! __get_cpuid(1, &a, &b, &c, &d)) return false;
+       #endif
+
+        constexpr unsigned int osxsave = 1u << 27, avx = 1u << 28, f16c = 1u << 29;
+        if ((c & (osxsave | avx | f16c)) != (osxsave | avx | f16c)) return false;
+
+       #if JUCE_MSVC
+        return (_xgetbv(0) & 6) == 6;
+       #else
+        unsigned int lo, hi;
+        __asm__ volatile ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+        return (lo & 6) == 6;
+       #endif
+    }();
+
+    return result;
+}
+
+/// Converts a multiple of eight contiguous floats to half precision, rounding to nearest even and clamping to the half range as floatToHalf() does. Only call if cpuHasF16C().
+MULTIDLY_F16C_TARGET static void floatsToHalvesF16C(const float* source, char* dest, int numSamples) noexcept
+{
+    const __m256 largest = _mm256_set1_ps(65504.0f), smallest = _mm256_set1_ps(-65504.0f);
+
+    for (int i = 0; i < numSamples; i += 8)
+    {
+        __m256 v = _mm256_loadu_ps(source + i);
+        v = _mm256_and_ps(v, _mm256_cmp_ps(v, v, _CMP_ORD_Q)); // NaN to zero
+        v = _mm256_max_ps(_mm256_min_ps(v, largest), smallest);
+
+        const __m128i h = _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + (size_t) i * 2), h);
+    }
+}
+
+/// Converts a multiple of eight contiguous half precision values to floats. Only call if cpuHasF16C().
+MULTIDLY_F16C_TARGET static void halvesToFloatsF16C(const char* source, float* dest, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; i += 8)
+    {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + (size_t) i * 2));
+        _mm256_storeu_ps(dest + i, _mm256_cvtph_ps(h));
+    }
+}
+#endif
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <sys/mman.h>
+#endif
+
+template<class T, int Ch>
+MultiDlyDelayBuffer<T, Ch>::MultiDlyDelayBuffer(DelayBufferLayout _layout, DelayBufferFormat _format, int _length) : layout(_layout), format(_format), length(_length)
+{
+    bytesPerSample = (format == DelayBufferFormat::Native ? (int) sizeof(T) : 2);
+
+    // a channel (or, interleaved, the whole buffer) rounded up to a whole number of cache lines
+    channelBytes = ((size_t) length * bytesPerSample + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    totalBytes = (layout == DelayBufferLayout::Planar ? channelBytes * Ch : (size_t) length * bytesPerSample * Ch);
+
+    // fresh pages from the OS are already zero and start on a page boundary, so there's nothing to clear or align.
+    memoryBytes = (totalBytes + PREFAULT_PAGE_SIZE - 1) / PREFAULT_PAGE_SIZE * PREFAULT_PAGE_SIZE;
+    memory = reservePages(memoryBytes);
+
+    // Without reserved pages there's no lazy commit, but the engine still needs a buffer. A zeroed heap block, aligned
+    // to a page like the reservation would have been, keeps everything else working; clear() just zeroes it.
+    if (memory == nullptr)
+    {
+        fallbackMemory.allocate(memoryBytes + PREFAULT_PAGE_SIZE, true);
+        memory = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(fallbackMemory.get()) + PREFAULT_PAGE_SIZE - 1) & ~(uintptr_t) (PREFAULT_PAGE_SIZE - 1));
+    }
+
+    char* start = memory;
+
+    if (layout == DelayBufferLayout::Planar)
+    {
+        sampleStride = bytesPerSample;
+        for (int chan = 0; chan < Ch; ++chan) channelStart[chan] = start + channelBytes * chan;
+    }
+    else
+    {
+        sampleStride = bytesPerSample * Ch;
+        for (int chan = 0; chan < Ch; ++chan) channelStart[chan] = start + bytesPerSample * chan;
+    }
+
+    for (int chan = 0; chan < Ch; ++chan) ditherState[chan] = 0x9e3779b9u * (uint32) (chan + 1); // any non-zero seed will do
+
+    backgroundThread->addTimeSliceClient(this);
+}
+
+
+template<class T, int Ch>
+MultiDlyDelayBuffer<T, Ch>::~MultiDlyDelayBuffer()
+{
+    // waits for the background thread if it is in the middle of our time slice
+    backgroundThread->removeTimeSliceClient(this);
+
+    if (fallbackMemory == nullptr) releasePages(memory, memoryBytes);
+}
+
+
+template<class T, int Ch>
+void MultiDlyDelayBuffer<T, Ch>::addSample(int chan, int index, T value) noexcept
+{
+    char* p = channelStart[chan] + (size_t) index * sampleStride;
+
+    switch (format)
+    {
+        case DelayBufferFormat::Half:
+            *reinterpret_cast<uint16*>(p) = floatToHalf((float) (getSample(chan, index) + value));
+            break;
+        case DelayBufferFormat::Fixed16:
+            *reinterpret_cast<int16*>(p) = toFixed16(getSample(chan, index) + value, ditherState[chan]);
+            break;
+        default:
+            *reinterpret_cast<T*>(p) += value;
+            break;
+    }
+}
+
+
+template<class T, int Ch>
+void MultiDlyDelayBuffer<T, Ch>::copyFrom(int chan, int destIndex, const T* source, int numSamples, uint32* ditherStateToUse) noexcept
+{
+    jassert(destIndex + numSamples <= length);
+
+    char* dest = channelStart[chan] + (size_t) destIndex * sampleStride;
+    int i = 0;
+
+    if (format == DelayBufferFormat::Native)
+    {
+        if (layout == DelayBufferLayout::Planar)
+        {
+            FloatVectorOperations::copy(reinterpret_cast<T*>(dest), source, numSamples);
+            return;
+        }
+
+        for (; i < numSamples; ++i) *reinterpret_cast<T*>(dest + (size_t) i * sampleStride) = source[i];
+        return;
+    }
+
+    if (format == DelayBufferFormat::Half)
+    {
+       #if JUCE_INTEL
+        if constexpr (std::is_same<T, float>::value)
+        {
+            // eight samples at a time, only when they are contiguous
+            if (layout == DelayBufferLayout::Planar && cpuHasF16C())
+            {
+                i = numSamples & ~7;
+                floatsToHalvesF16C(source, dest, i);
+            }
+        }
+       #endif
+
+        for (; i < numSamples; ++i) *reinterpret_cast<uint16*>(dest + (size_t) i * sampleStride) = floatToHalf((float) source[i]);
+        return;
+    }
+
+    uint32& state = ditherStateToUse != nullptr ? *ditherStateToUse : ditherState[chan];
+
+   #if JUCE_INTEL
+    if constexpr (std::is_same<T, float>::value)
+    {
+        if (layout == DelayBufferLayout::Planar)
+        {
+            // The generator is serial, so the dither is still made one value at a time, but the scaling, rounding and
+            // saturation are done eight samples at a time. The clamp keeps huge values from wrapping in the conversion.
+            const __m128 scale = _mm_set1_ps(32768.0f), lowest = _mm_set1_ps(-32768.0f), highest = _mm_set1_ps(32767.0f);
+
+            for (; i + 8 <= numSamples; i += 8)
+            {
+                alignas(16) float dither[8];
+                for (auto& d : dither) d = nextDither(state);
+
+                const __m128 a = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(source + i), scale), _mm_load_ps(dither));
+                const __m128 b = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(source + i + 4), scale), _mm_load_ps(dither + 4));
+                const __m128i lo = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(a, lowest), highest));
+                const __m128i hi = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(b, lowest), highest));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + (size_t) i * 2), _mm_packs_epi32(lo, hi));
+            }
+        }
+    }
+   #endif
+
+    for (; i < numSamples; ++i) *reinterpret_cast<int16*>(dest + (size_t) i * sampleStride) = toFixed16(source[i], state);
+}
+
+
+template<class T, int Ch>
+void MultiDlyDelayBuffer<T, Ch>::copyTo(int chan, int sourceIndex, T* dest, int numSamples) const noexcept
+{
+    jassert(sourceIndex + numSamples <= length);
+
+    const char* src = channelStart[chan] + (size_t) sourceIndex * sampleStride;
+    int i = 0;
+
+    if (layout == DelayBufferLayout::Planar)
+    {
+        if (format == DelayBufferFormat::Native)
+        {
+            FloatVectorOperations::copy(dest, reinterpret_cast<const T*>(src), numSamples);
+            return;
+        }
+
+       #if JUCE_INTEL
+        if constexpr (std::is_same<T, float>::value)
+        {
+            if (format == DelayBufferFormat::Fixed16)
+            {
+                // sign-extend eight int16s to two sets of four int32s, then convert and scale
+                const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+                for (; i + 8 <= numSamples; i += 8)
+                {
+                    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (size_t) i * 2));
+                    const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+                    const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+                    _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+                    _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+                }
+            }
+            else if (cpuHasF16C())
+            {
+                i = numSamples & ~7;
+                halvesToFloatsF16C(src, dest, i);
+            }
+        }
+       #endif
+    }
+
+    for (; i < numSamples; ++i) dest[i] = getSample(chan, sourceIndex + i);
+}
+
+
+template<class T, int Ch>
+void MultiDlyDelayBuffer<T, Ch>::clear(bool releaseMemory)
+{
+    if (! releaseMemory)
+    {
+        zeromem(memory, memoryBytes);
+        return;
+    }
+
+   #if JUCE_WINDOWS
+    zeromem(memory, memoryBytes);
+   #else
+    // private anonymous pages read back as zero after this, and stop counting as resident
+    if (fallbackMemory != nullptr || madvise(memory, memoryBytes, MADV_DONTNEED) != 0) zeromem(memory, memoryBytes);
+   #endif
+
+    // The pages are gone, so prefaulting has to start again from the beginning. The background thread is kept off the
+    // buffer while it is reset, and the buffer is handed back to it in case it had finished and dropped it.
+    backgroundThread->removeTimeSliceClient(this);
+    prefaultedUpTo = 0;
+    prefaultTarget.store(0);
+    backgroundThread->addTimeSliceClient(this);
+}
+
+
+template<class T, int Ch>
+void MultiDlyDelayBuffer<T, Ch>::prefault(int startIndex, int numSamples)
+{
+    startIndex = jlimit(0, length, startIndex);
+    numSamples = jlimit(0, length - startIndex, numSamples);
+    if (numSamples == 0) return;
+
+    if (layout == DelayBufferLayout::Planar)
+    {
+        for (int chan = 0; chan < Ch; ++chan) touchPages(channelStart[chan] + (size_t) startIndex * sampleStride, (size_t) numSamples * sampleStride);
+    }
+    else
+    {
+        // every channel of a frame is in the same run of memory
+        touchPages(channelStart[0] + (size_t) startIndex * sampleStride, (size_t) numSamples * sampleStride);
+    }
+}
+
+
+template<class T, int Ch>
+int MultiDlyDelayBuffer<T, Ch>::useTimeSlice()
+{
+    // everything has been committed, so there's nothing more to do for this buffer.
+    if (prefaultedUpTo >= length) return -1;
+
+    const int target = prefaultTarget.load(std::memory_order_relaxed);
+    if (prefaultedUpTo >= target) return 20; // caught up, so check back in a little while
+
+    const int numSamples = jmin(PREFAULT_CHUNK_SAMPLES, target - prefaultedUpTo);
+    prefault(prefaultedUpTo, numSamples);
+    prefaultedUpTo += numSamples;
+
+    return 0;
+}
+
+
+template<class T, int Ch>
+char* MultiDlyDelayBuffer<T, Ch>::reservePages(size_t numBytes)
+{
+   #if JUCE_WINDOWS
+    // committed memory on Windows is still only backed by a physical page once it is first touched
+    return static_cast<char*>(VirtualAlloc(nullptr, numBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+   #else
+    void* pages = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return pages == MAP_FAILED ? nullptr : static_cast<char*>(pages);
+   #endif
+}
+
+
+template<class T, int Ch>
+void MultiDlyDelayBuffer<T, Ch>::releasePages(char* pages, size_t numBytes)
+{
+    if (pages == nullptr) return;
+
+   #if JUCE_WINDOWS
+    ignoreUnused(numBytes);
+    VirtualFree(pages, 0, MEM_RELEASE);
+   #else
+    munmap(pages, numBytes);
+   #endif
+}
+
+
+template<class T, int Ch>
+void MultiDlyDelayBuffer<T, Ch>::touchPages(char* start, size_t numBytes)
+{
+    if (numBytes == 0) return;
+
+   #if JUCE_LINUX && defined(MADV_POPULATE_WRITE)
+    // Linux 5.14 and later can commit the pages directly, without us touching them at all
+    char* firstPage = reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(start) & ~(uintptr_t) (PREFAULT_PAGE_SIZE - 1));
+    if (madvise(firstPage, (size_t) (start + numBytes - firstPage), MADV_POPULATE_WRITE) == 0) return;
+   #endif
+
+    // The audio thread may be reading or writing these pages at the same time, so each one is touched with an atomic
+    // read-modify-write that adds nothing. That commits the page without ever losing a sample the audio thread wrote.
+    for (size_t offset = 0; offset < numBytes + PREFAULT_PAGE_SIZE - 1; offset += PREFAULT_PAGE_SIZE)
+    {
+        char* p = start + jmin(offset, numBytes - 1);
+
+       #if JUCE_MSVC
+        _InterlockedOr8(p, 0);
+       #else
+        __atomic_fetch_or(p, (char) 0, __ATOMIC_RELAXED);
+       #endif
+    }
+}
+
+
+template<class T, int Ch>
+int16 MultiDlyDelayBuffer<T, Ch>::toFixed16(T value, uint32& s) noexcept
+{
+    return (int16) jlimit(-32768, 32767, roundToInt((float) value * 32768.0f + nextDither(s)));
+}
+
+
+template<class T, int Ch>
+float MultiDlyDelayBuffer<T, Ch>::nextDither(uint32& s) noexcept
+{
+    // xorshift32, with the two halves of each output used as the two uniform values of the TPDF dither
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+
+    return ((float) (s & 0xffff) - (float) (s >> 16)) * (1.0f / 65536.0f); // triangular, within one LSB either way
+}
+
+
+template<class T, int Ch>
+uint16 MultiDlyDelayBuffer<T, Ch>::floatToHalf(float f) noexcept
+{
+    uint32 x;
+    std::memcpy(&x, &f, sizeof(x));
+
+    const uint32 sign = (x >> 16) & 0x8000;
+    x &= 0x7fffffff;
+
+    // An infinity or NaN written here would go round through the feedback forever, so anything too large for a half,
+    // or infinite, becomes the largest half, and NaN becomes silence.
+    if (x > 0x7f800000) return 0;
+    if (x >= 0x47800000) return (uint16) (sign | 0x7bff);
+
+    // smaller than the smallest normal half, so it becomes a subnormal (or zero)
+    if (x < 0x38800000)
+    {
+        if (x < 0x33000000) return (uint16) sign;
+
+        const uint32 e = x >> 23;
+        const uint32 m = (x & 0x7fffff) | 0x800000;
+        const uint32 shift = 126 - e;
+
+        const uint32 shifted = m >> shift;
+        const uint32 rem = m & ((1u << shift) - 1);
+        const uint32 halfway = 1u << (shift - 1);
+
+        return (uint16) (sign | (shifted + ((rem > halfway || (rem == halfway && (shifted & 1))) ? 1 : 0)));
+    }
+
+    // rebias the exponent from 127 to 15 and drop 13 bits of mantissa, rounding to nearest even. A carry out of the
+    // mantissa correctly bumps the exponent, but not past the largest half.
+    uint32 h = (x - 0x38000000) >> 13;
+    const uint32 rem = x & 0x1fff;
+    h += ((rem > 0x1000 || (rem == 0x1000 && (h & 1))) ? 1 : 0);
+
+    return (uint16) (sign | jmin(h, (uint32) 0x7bff));
+}
+
+
+template<class T, int Ch>
+float MultiDlyDelayBuffer<T, Ch>::halfToFloat(uint16 h) noexcept
+{
+    const uint32 sign = (uint32) (h & 0x8000) << 16;
+    uint32 e = (h >> 10) & 0x1f;
+    uint32 m = h & 0x3ff;
+    uint32 x;
+
+    if (e == 0)
+    {
+        if (m == 0)
+        {
+            x = sign;
+        }
+        else
+        {
+            // subnormal half, which is a normal float once the mantissa is shifted up to its leading one
+            e = 113;
+            while ((m & 0x400) == 0) { m <<= 1; --e; }
+            x = sign | (e << 23) | ((m & 0x3ff) << 13);
+        }
+    }
+    else if (e == 31)
+    {
+        x = sign | 0x7f800000 | (m << 13);
+    }
+    else
+    {
+        x = sign | ((e + 112) << 23) | (m << 13);
+    }
+
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+
+// the same channel counts as createMultiDlyEngine()
+template class MultiDlyDelayBuffer<float, 1>;
+template class MultiDlyDelayBuffer<float, 2>;
+template class MultiDlyDelayBuffer<float, 4>;
+template class MultiDlyDelayBuffer<float, 6>;
+template class MultiDlyDelayBuffer<float, 8>;
+template class MultiDlyDelayBuffer<float, 12>;
+template class MultiDlyDelayBuffer<float, 16>;
+template class MultiDlyDelayBuffer<float, 24>;
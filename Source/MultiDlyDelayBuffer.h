@@ -0,0 +1,235 @@
+/*
+  ==============================================================================
+
+    MultiDlyDelayBuffer.h
+    Created: 19 Oct 2026 11:40:27am
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#define CACHE_LINE_SIZE 64
+#define PREFAULT_PAGE_SIZE 4096 // the smallest page size of any platform we run on; larger pages just get touched more than once
+#define PREFAULT_CHUNK_SAMPLES 16384 // how much the background thread touches per time slice
+
+#include <JuceHeader.h>
+#include "MultiDlyBackgroundThread.h"
+
+
+/// The memory layouts a MultiDlyDelayBuffer can use.
+enum class DelayBufferLayout
+{
+    /// Each channel is a separate contiguous run of samples, each starting on its own cache line. Channels can be written by different threads without sharing cache lines.
+    Planar,
+    /// Frame-major: all channels of a sample are next to each other. Reading every channel at one delay touches one contiguous run of memory, so a multichannel tap read is a single stream.
+    Interleaved
+};
+
+
+/**
+ The formats a MultiDlyDelayBuffer can store its history in.
+
+ Only the stored history is affected: samples are converted to the engine's processing type as they are read, so the taps' filters, waveshapers and compressors always run at full precision. The quality cost is paid once per trip through the buffer, so it accumulates with every repeat of a high-feedback tap.
+ */
+enum class DelayBufferFormat
+{
+    /// The engine's processing type. Lossless, and the default.
+    Native,
+
+    /**
+     IEEE 754 half precision (11 significant bits). Half the memory and read bandwidth of float.
+
+     The error is relative to the signal, at roughly -66 dB below it, so quiet tails stay as clean as loud ones and there is no fixed noise floor. Values beyond ±65504 are clamped to it, and NaN is stored as silence, so neither can recirculate through the feedback as an infinity or NaN.
+     */
+    Half,
+
+    /**
+     16-bit fixed point over [-1, 1), with TPDF dither. Half the memory and read bandwidth of float.
+
+     The dither gives a constant, signal-independent noise floor of about -93 dBFS and no truncation distortion, but anything beyond full scale is clipped, so high-feedback patches that build up above 0 dBFS in the buffer will distort where the other formats wouldn't.
+     */
+    Fixed16
+};
+
+
+/**
+ @brief The circular buffer of delay history owned by a MultiDlyEngine.
+
+ The memory is reserved as lazily committed zero pages rather than allocated and cleared, so constructing an engine is nearly free and an instance which never plays costs almost no resident memory. Pages are committed a little ahead of the write index by the shared MultiDlyBackgroundThread, so the audio thread never takes the page fault itself, as long as the owner never reads further back than it has written; MultiDlyEngine reads older history as silence. Once the write index has been all the way round the buffer, every page is committed and the prefaulting stops.
+
+ The accessors mirror the parts of `AudioBuffer` the engine used before it had a choice of layout, so that the engine doesn't need to care which layout or format it is using. Every sample is found at `channelStart[chan] + index * sampleStride` bytes, which covers both layouts without branching; the format is a single, perfectly predicted branch per access.
+
+ @tparam T The engine's processing type
+ @tparam Ch The number of channels
+ */
+template <class T, int Ch>
+class MultiDlyDelayBuffer : private TimeSliceClient
+{
+public:
+
+    /**
+     @brief Constructor. Allocates and clears the buffer.
+
+     @param _layout The memory layout to use.
+     @param _format The format to store samples in.
+     @param _length The length of each channel, in samples.
+     */
+    MultiDlyDelayBuffer(DelayBufferLayout _layout, DelayBufferFormat _format, int _length);
+
+    /// @brief Destructor. Stops prefaulting and releases the memory.
+    ~MultiDlyDelayBuffer() override;
+
+    /// @brief Gets the layout chosen at construction.
+    DelayBufferLayout getLayout() const { return layout; }
+
+    /// @brief Gets the storage format chosen at construction.
+    DelayBufferFormat getFormat() const { return format; }
+
+    /// @brief Gets the length of each channel, in samples.
+    int getNumSamples() const { return length; }
+
+    /// @brief Gets the number of channels, which is always Ch.
+    int getNumChannels() const { return Ch; }
+
+    /// @brief Gets the size of one stored sample, in bytes.
+    int getBytesPerSample() const { return bytesPerSample; }
+
+    /// @brief Gets a sample, converted to T.
+    T getSample(int chan, int index) const noexcept
+    {
+        const char* p = channelStart[chan] + (size_t) index * sampleStride;
+
+        switch (format)
+        {
+            case DelayBufferFormat::Half:    return (T) halfToFloat(*reinterpret_cast<const uint16*>(p));
+            case DelayBufferFormat::Fixed16: return (T) (*reinterpret_cast<const int16*>(p) * (1.0f / 32768.0f));
+            default:                         return *reinterpret_cast<const T*>(p);
+        }
+    }
+
+    /**
+     @brief Gets a pointer to a sample which can be read contiguously, or nullptr if the buffer's layout or format means the samples of a channel aren't stored as a plain run of T.
+
+     Only planar, native buffers can be read in place; everything else has to go through copyTo().
+     */
+    const T* getContiguousReadPointer(int chan, int index) const noexcept
+    {
+        if (layout != DelayBufferLayout::Planar || format != DelayBufferFormat::Native) return nullptr;
+        return reinterpret_cast<const T*>(channelStart[chan] + (size_t) index * sampleStride);
+    }
+
+    /**
+     @brief Reads channels [firstChan, lastChan) of one sample, converted to T, into the same entries of dest.
+
+     In the interleaved native layout the channels are next to each other, so this is a single contiguous load of the whole frame. Every other layout and format reads the channels one at a time.
+     */
+    void readFrame(int index, int firstChan, int lastChan, T* dest) const noexcept
+    {
+        if (layout == DelayBufferLayout::Interleaved && format == DelayBufferFormat::Native)
+        {
+            std::memcpy(dest + firstChan, channelStart[firstChan] + (size_t) index * sampleStride, sizeof(T) * (size_t) (lastChan - firstChan));
+            return;
+        }
+
+        for (int chan = firstChan; chan < lastChan; ++chan) dest[chan] = getSample(chan, index);
+    }
+
+    /// @brief Adds a value to a sample. For the compact formats the sum is rounded (and dithered) once.
+    void addSample(int chan, int index, T value) noexcept;
+
+    /**
+     @brief Overwrites a run of samples in one channel, converting them to the storage format. The run must not go past the end of the buffer.
+
+     @param chan The channel to write to.
+     @param destIndex The first sample to write.
+     @param source The samples to write.
+     @param numSamples The number of samples to write.
+     @param ditherStateToUse The dither generator for a 16-bit buffer. Leave this as nullptr on the audio thread; any other thread writing at the same time must bring its own, as the channel's generator isn't shared safely.
+     */
+    void copyFrom(int chan, int destIndex, const T* source, int numSamples, uint32* ditherStateToUse = nullptr) noexcept;
+
+    /**
+     @brief Reads a run of samples from one channel, converting them to T. The run must not go past the end of the buffer.
+
+     @param chan The channel to read from.
+     @param sourceIndex The first sample to read.
+     @param dest Where to put the samples.
+     @param numSamples The number of samples to read.
+     */
+    void copyTo(int chan, int sourceIndex, T* dest, int numSamples) const noexcept;
+
+    /**
+     @brief Clears the whole buffer.
+
+     Where possible, the memory is handed back to the OS as zero pages, so this also drops the buffer's resident memory. The background thread then starts committing it again from the beginning, once the owner sets a new target with setPrefaultTarget(). Don't call this while audio is running.
+
+     @param releaseMemory Pass false to write zeros over the memory instead, so it stays committed and the audio thread won't fault on it afterwards.
+     */
+    void clear(bool releaseMemory = true);
+
+
+    /**
+     @brief Commits every page holding samples [startIndex, startIndex + numSamples) of every channel, without changing any sample.
+
+     This is what the background thread does; call it directly to commit the memory the first blocks will need before playback starts.
+     */
+    void prefault(int startIndex, int numSamples);
+
+    /**
+     @brief Tells the background thread how far ahead of the write index it should have committed memory.
+
+     This is a single atomic store, and is intended to be called from the audio thread after every block. Values past the end of the buffer are clipped.
+
+     @param endIndex The sample index, exclusive, up to which memory should be committed.
+     */
+    void setPrefaultTarget(int endIndex) noexcept { prefaultTarget.store(jmin(endIndex, length), std::memory_order_relaxed); }
+
+
+    /// @brief Converts a float to IEEE 754 half precision, rounding to nearest even.
+    static uint16 floatToHalf(float f) noexcept;
+
+    /// @brief Converts an IEEE 754 half precision value to float.
+    static float halfToFloat(uint16 h) noexcept;
+
+private:
+
+    /// Converts a value to 16-bit fixed point with TPDF dither, using and advancing a dither state.
+    static int16 toFixed16(T value, uint32& state) noexcept;
+
+    /// Advances a dither state and returns its next TPDF dither value, in 16-bit LSBs.
+    static float nextDither(uint32& state) noexcept;
+
+    /// TimeSliceClient callback, which prefaults the next chunk up to prefaultTarget.
+    int useTimeSlice() override;
+
+    /// Reserves `numBytes` of zero pages, or returns nullptr on failure.
+    static char* reservePages(size_t numBytes);
+
+    /// Releases memory from reservePages().
+    static void releasePages(char* pages, size_t numBytes);
+
+    /// Commits the pages covering [start, start + numBytes) without changing their contents.
+    static void touchPages(char* start, size_t numBytes);
+
+    const DelayBufferLayout layout;
+    const DelayBufferFormat format;
+    const int length;
+    int bytesPerSample, sampleStride; // sampleStride is in bytes
+    size_t totalBytes; // from channelStart[0] to the end of the last channel
+
+    char* memory = nullptr;
+    size_t memoryBytes = 0;
+    HeapBlock<char> fallbackMemory; // used instead of reserved pages if the OS won't reserve them, in which case memory points into it
+    std::array<char*, Ch> channelStart;
+    size_t channelBytes;
+
+    juce::SharedResourcePointer<MultiDlyBackgroundThread> backgroundThread;
+    std::atomic<int> prefaultTarget { 0 };
+    int prefaultedUpTo = 0; // only used by the background thread
+
+    std::array<uint32, Ch> ditherState; // one generator per channel, so channel groups on different threads don't share one
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiDlyDelayBuffer)
+};
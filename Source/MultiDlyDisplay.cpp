@@ -14,39 +14,194 @@
 //==============================================================================
 MultiDlyDisplay::MultiDlyDisplay(MultiDlyAudioProcessor& _p) : p(_p)
 {
-    // In your constructor, you should add any child components, and
-    // initialise any special settings that your component needs.
+    markers.fill(-1);
 
+    startTimerHz(DISPLAY_FRAME_RATE_HZ);
 }
 
-MultiDlyDisplay::~MultiDlyDisplay()
+void MultiDlyDisplay::timerCallback()
 {
+    if (paintTimer.shouldSkipFrame(1000.0 / DISPLAY_FRAME_RATE_HZ)) return;
+
+    // a copy of the shared_ptr, so the engine can't go away underneath us if the processor replaces it
+    auto engine = p.getEngine();
+    if (engine == nullptr) return;
+
+    const int numChannels = levels.numChannels;
+
+    if (engine->getLatestLevels(levels))
+    {
+        // the meter strip changes width with the channel count, which moves everything else
+        if (levels.numChannels != numChannels) repaint();
+        else repaint(getMeterBounds());
+    }
+
+    const auto& history = engine->getHistory();
+
+    // the same hash as the engine's static tap signature
+    uint64 key = 14695981039346656037ull;
+
+    for (int t = 0; t < HISTORY_MAX_MARKERS; ++t)
+    {
+        markers[(size_t) t] = history.getMarker(t);
+        key = (key ^ (uint32) markers[(size_t) t]) * 1099511628211ull;
+    }
+
+    const int64 samplesWritten = history.getNumSamplesWritten();
+
+    if (samplesWritten != lastSamplesWritten || key != markerKey)
+    {
+        lastSamplesWritten = samplesWritten;
+        markerKey = key;
+        repaint(getHistoryBounds());
+    }
 }
 
-void MultiDlyDisplay::paint (juce::Graphics& g)
+Rectangle<int> MultiDlyDisplay::getMeterBounds() const
 {
-    /* This demo code just fills the component's background and
-       draws some placeholder text to get you started.
+    return getLocalBounds().reduced(1).removeFromRight(jmax(1, levels.numChannels) * DISPLAY_METER_WIDTH * 2);
+}
 
-       You should replace everything in this method with your own
-       drawing code..
-    */
+Rectangle<int> MultiDlyDisplay::getHistoryBounds() const
+{
+    auto area = getLocalBounds().reduced(1);
+    area.removeFromRight(getMeterBounds().getWidth());
+    return area;
+}
+
+void MultiDlyDisplay::drawMeter(Graphics& g, Rectangle<float> area, LevelSnapshot::Level level)
+{
+    auto toProportion = [] (float gain) { return jlimit(0.0f, 1.0f, jmap(Decibels::gainToDecibels(gain, -60.0f), -60.0f, 6.0f, 0.0f, 1.0f)); };
+
+    g.setColour(Colours::green);
+    g.fillRect(area.withTop(area.getBottom() - area.getHeight() * toProportion(level.rms)));
+
+    g.setColour(level.peak >= 1.0f ? Colours::red : Colours::white);
+    const float peakY = area.getBottom() - area.getHeight() * toProportion(level.peak);
+    g.drawHorizontalLine((int) peakY, area.getX(), area.getRight());
+}
 
+void MultiDlyDisplay::renderBackground(Graphics& g, Rectangle<int> area, double sampleRate, int historyLength)
+{
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));   // clear the background
 
     g.setColour (juce::Colours::grey);
-    g.drawRect (getLocalBounds(), 1);   // draw an outline around the component
-    g.setColour (juce::Colours::white);
-    g.setFont (14.0f);
-    g.drawText ("MultiDlyDisplay", getLocalBounds(),
-                juce::Justification::centred, true);   // draw some placeholder text
+    g.drawRect (area, 1);   // draw an outline around the component
+
+    if (sampleRate <= 0.0 || historyLength <= 0) return;
+
+    // a line for every second behind the newest sample, labelled along the bottom
+    auto historyArea = getHistoryBounds();
+    const double pixelsPerSecond = historyArea.getWidth() * sampleRate / historyLength;
+
+    g.setFont (10.0f);
+
+    for (int seconds = 1; seconds * pixelsPerSecond < historyArea.getWidth(); ++seconds)
+    {
+        const int x = historyArea.getRight() - 1 - (int) (seconds * pixelsPerSecond);
+
+        g.setColour (juce::Colours::grey.withAlpha(0.4f));
+        g.drawVerticalLine (x, (float) historyArea.getY(), (float) historyArea.getBottom());
+
+        g.setColour (juce::Colours::grey);
+        g.drawText ("-" + String(seconds) + "s", x + 2, historyArea.getBottom() - 12, 30, 12, juce::Justification::centredLeft, false);
+    }
 }
 
-void MultiDlyDisplay::resized()
+void MultiDlyDisplay::renderMarkers(Graphics& g, Rectangle<int> area, int historyLength)
+{
+    const float pixelsPerSample = (float) area.getWidth() / historyLength;
+    g.setColour(Colours::orange);
+
+    for (int delay : markers)
+    {
+        if (delay < 0) continue;
+        g.drawVerticalLine(area.getRight() - 1 - (int) (delay * pixelsPerSample), (float) area.getY(), (float) area.getBottom());
+    }
+}
+
+void MultiDlyDisplay::drawHistory(Graphics& g, Rectangle<int> area, const MultiDlyHistoryPyramid& history)
+{
+    const int width = jmin(area.getWidth(), (int) columns.size());
+    if (width <= 0) return;
+
+    history.getColumns(columns.data(), width, history.getHistoryLength());
+
+    const float centre = (float) area.getCentreY();
+    const float scale = area.getHeight() * 0.5f;
+
+    g.setColour(Colours::lightblue);
+
+    for (int x = 0; x < width; ++x)
+    {
+        const auto& c = columns[(size_t) x];
+        if (c.isEmpty()) continue;
+
+        const float top = centre - jmin(1.0f, c.max) * scale;
+        const float bottom = centre - jmax(-1.0f, c.min) * scale;
+        g.drawVerticalLine(area.getX() + x, top, jmax(top + 1.0f, bottom));
+    }
+}
+
+MultiDlyDisplay::~MultiDlyDisplay()
 {
-    // This method is where you should set the bounds of any child
-    // components that your component contains..
+}
 
+void MultiDlyDisplay::paint (juce::Graphics& g)
+{
+    PaintTimer::ScopedMeasurement measurement(paintTimer);
+
+    // as with the timer, the copy keeps the engine, and so its history, alive while we draw
+    auto engine = p.getEngine();
+    const int historyLength = engine != nullptr ? engine->getHistory().getHistoryLength() : 0;
+    const double sampleRate = p.getSampleRate();
+
+    // everything the background depends on, besides its size
+    const uint64 backgroundKey = ((uint64) levels.numChannels << 32) ^ (uint64) historyLength ^ ((uint64) roundToInt(sampleRate) << 40);
+    backgroundLayer.draw(g, getLocalBounds(), backgroundKey, [&] (Graphics& lg, Rectangle<int> area) { renderBackground(lg, area, sampleRate, historyLength); });
+
+    // only draw what the repaint asked for: most frames are either the history or the meters, not both
+    const auto clip = g.getClipBounds();
+    const auto historyArea = getHistoryBounds();
+
+    if (engine == nullptr)
+    {
+        g.setColour (juce::Colours::white);
+        g.setFont (14.0f);
+        g.drawText ("MultiDlyDisplay", getLocalBounds(),
+                    juce::Justification::centred, true);   // draw some placeholder text
+    }
+    else if (clip.intersects(historyArea))
+    {
+        drawHistory(g, historyArea, engine->getHistory());
+        markerLayer.draw(g, historyArea, markerKey, [&] (Graphics& lg, Rectangle<int> area) { renderMarkers(lg, area, historyLength); });
+
+       #if MULTIDLY_PAINT_TIMING_OVERLAY
+        g.setColour (juce::Colours::grey);
+        g.setFont (10.0f);
+        g.drawText ("paint " + String(paintTimer.getMeanMs(), 2) + " ms  worst " + String(paintTimer.getWorstMs(), 2) + " ms",
+                    historyArea.reduced(4).removeFromTop(12), juce::Justification::topLeft, false);
+       #endif
+    }
+
+    if (clip.intersects(getMeterBounds()))
+    {
+        // inputs on the left of the strip, outputs on the right
+        auto meters = getMeterBounds().toFloat();
+        auto inputs = meters.removeFromLeft(meters.getWidth() / 2);
+
+        for (int chan = 0; chan < levels.numChannels; ++chan)
+        {
+            drawMeter(g, inputs.removeFromLeft((float) DISPLAY_METER_WIDTH).reduced(1.0f, 0.0f), levels.input[chan]);
+            drawMeter(g, meters.removeFromLeft((float) DISPLAY_METER_WIDTH).reduced(1.0f, 0.0f), levels.output[chan]);
+        }
+    }
+}
+
+void MultiDlyDisplay::resized()
+{
+    // sized for the whole width, as the history's share of it changes with the number of meters
+    columns.resize((size_t) jmax(0, getLocalBounds().reduced(1).getWidth()));
 }
 
 void MultiDlyDisplay::mouseDown (const MouseEvent& event)
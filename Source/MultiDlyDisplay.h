@@ -13,11 +13,22 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "MultiDlyTap.h"
+#include "CachedLayer.h"
+
+#define DISPLAY_FRAME_RATE_HZ 30
+#define DISPLAY_METER_WIDTH 6 // per channel, for each of input and output
+
+#ifndef MULTIDLY_PAINT_TIMING_OVERLAY
+ #define MULTIDLY_PAINT_TIMING_OVERLAY 0 // set by the MULTIDLY_PAINT_TIMING_OVERLAY CMake option
+#endif
 
 //==============================================================================
 /*
+ The main view of the delay. Draws the whole delay history as a min/max waveform, newest on the right, with a line where each tap reads from, and the input and output levels of every channel along its right edge.
+
+ The waveform comes from the engine's MultiDlyHistoryPyramid, so a frame costs a few bins per pixel however long the history is. The background and time ruler, and the tap markers, are cached layers which are only re-rendered when the sample rate, the channel count or the tap times change. Each frame only repaints the history if a block has been written since the last one, and the meters if there are new levels.
 */
-class MultiDlyDisplay  : public Component
+class MultiDlyDisplay  : public Component, private Timer
 {
 public:
     MultiDlyDisplay(MultiDlyAudioProcessor& _p);
@@ -30,9 +41,40 @@ public:
     void mouseDrag (const MouseEvent& event) override;
     void mouseUp (const MouseEvent& event) override;
 
+    /// Gets how long this component takes to paint.
+    const PaintTimer& getPaintTimer() const { return paintTimer; }
 
 private:
+    void timerCallback() override;
+
+    /// Gets the strip along the right edge that the bus meters are drawn in.
+    Rectangle<int> getMeterBounds() const;
+
+    /// Gets the area the history is drawn in, which is everything left of the meters.
+    Rectangle<int> getHistoryBounds() const;
+
+    /// Draws one meter: a bar for the RMS level with a line at the peak, both on a dB scale.
+    static void drawMeter(Graphics& g, Rectangle<float> area, LevelSnapshot::Level level);
+
+    /// Renders the background layer: the background, outline and a ruler line for every second of history.
+    void renderBackground(Graphics& g, Rectangle<int> area, double sampleRate, int historyLength);
+
+    /// Renders the marker layer: a line at each tap, at how far behind the newest sample it reads.
+    void renderMarkers(Graphics& g, Rectangle<int> area, int historyLength);
+
+    /// Draws the history waveform into area.
+    void drawHistory(Graphics& g, Rectangle<int> area, const MultiDlyHistoryPyramid& history);
+
     MultiDlyAudioProcessor& p;
+    LevelSnapshot levels; // the last levels taken from the engine
+    std::vector<MultiDlyHistoryPyramid::Range> columns; // one per pixel of the history's width, sized by resized()
+
+    CachedLayer backgroundLayer, markerLayer;
+    std::array<int, HISTORY_MAX_MARKERS> markers; // the tap markers the marker layer was last asked to draw
+    uint64 markerKey = 0; // a hash of markers
+    int64 lastSamplesWritten = -1; // the history's position at the last frame, to tell whether it has moved since
+
+    PaintTimer paintTimer;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiDlyDisplay)
 };
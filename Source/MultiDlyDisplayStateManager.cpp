@@ -10,6 +10,67 @@
 
 #include "MultiDlyDisplayStateManager.h"
 
+
+bool MultiDlyDisplayStateManagerBase::readTapIfChanged(int index, TapDisplayState& dest, uint32& knownVersion) const
+{
+    for (;;)
+    {
+        const auto& snapshot = snapshots[getGeneration() & 1];
+
+        const uint32 before = snapshot.sequence.load(std::memory_order_acquire);
+        if (before & 1) continue; // the engine has come round to this buffer again and is writing it
+
+        const auto& tap = snapshot.taps[(size_t) index];
+        const uint32 version = tap.version;
+
+        if (version == knownVersion)
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (snapshot.sequence.load(std::memory_order_relaxed) == before) return false;
+            continue;
+        }
+
+        TapDisplayState copy = tap;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (snapshot.sequence.load(std::memory_order_relaxed) != before) continue;
+
+        dest = copy;
+        knownVersion = version;
+        return true;
+    }
+}
+
+
+void MultiDlyDisplayStateManagerBase::publish() noexcept
+{
+    bool changed = false;
+
+    for (size_t i = 0; i < pending.size(); ++i)
+    {
+        if (pending[i].sameAs(published[i])) continue;
+
+        pending[i].version = nextVersion++;
+        published[i] = pending[i];
+        changed = true;
+    }
+
+    if (! changed) return;
+
+    const uint32 next = generation.load(std::memory_order_relaxed) + 1;
+    auto& snapshot = snapshots[next & 1];
+
+    snapshot.sequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    snapshot.taps = published;
+
+    snapshot.sequence.fetch_add(1, std::memory_order_release);
+    generation.store(next, std::memory_order_release);
+}
+
+
+//==============================================================================
 template<class T, int C>
 MultiDlyDisplayStateManager<T, C>::MultiDlyDisplayStateManager()
 {
@@ -23,7 +84,39 @@ MultiDlyDisplayStateManager<T, C>::~MultiDlyDisplayStateManager()
 }
 
 template<class T, int C>
-bool MultiDlyDisplayStateManager<T, C>::AddNewTap()
+void MultiDlyDisplayStateManager<T, C>::publish(const std::array<std::shared_ptr<MultiDlyTap<T, C>>, DISPLAY_STATE_MAX_TAPS>& taps) noexcept
 {
+    for (int i = 0; i < DISPLAY_STATE_MAX_TAPS; ++i)
+    {
+        auto& state = getPendingTap(i);
+        MultiDlyTap<T, C>* tap = taps[(size_t) i].get();
+
+        if (tap == nullptr)
+        {
+            state = TapDisplayState();
+            continue;
+        }
 
+        state.tapId = tap;
+        state.hostSlot = tap->getHostSlot();
+        state.timeMs = tap->getTimeMsTargetValue();
+        state.mix = tap->getMix();
+        state.feedback = tap->getFeedback();
+        state.filterIn = tap->getFiltIn();
+        state.waveshaperIn = tap->getWSIn();
+        state.compressorIn = tap->getCompIn();
+        state.isStatic = tap->isStatic();
+    }
+
+    MultiDlyDisplayStateManagerBase::publish();
 }
+
+
+template class MultiDlyDisplayStateManager<float, 1>;
+template class MultiDlyDisplayStateManager<float, 2>;
+template class MultiDlyDisplayStateManager<float, 4>;
+template class MultiDlyDisplayStateManager<float, 6>;
+template class MultiDlyDisplayStateManager<float, 8>;
+template class MultiDlyDisplayStateManager<float, 12>;
+template class MultiDlyDisplayStateManager<float, 16>;
+template class MultiDlyDisplayStateManager<float, 24>;
@@ -10,6 +10,8 @@
 
 #pragma once
 
+#define DISPLAY_STATE_MAX_TAPS 32 // must be the same as MAX_NUM_DLY_TAPS
+
 
 #include <JuceHeader.h>
 #include "MultiDlyTap.h"
@@ -17,22 +19,98 @@
 class MultiDlyAudioProcessor;
 
 
-class MultiDlyDisplayStateManagerBase {};
+/**
+ @brief What the editors need to know about one tap, as published by the audio thread.
+ */
+struct TapDisplayState
+{
+    const void* tapId = nullptr; ///< the MultiDlyTap this is the state of, as in LevelSnapshot; nullptr for an empty slot
+    uint32 version = 0; ///< changes whenever anything else here does, including which tap is in the slot
+    int hostSlot = -1; ///< the tap's MultiDlyTap::getHostSlot(), which is how an editor finds its host parameters
+
+    double timeMs = 0.0; ///< where the tap's time is heading, rather than where a ramp has got to
+    double mix = 0.0;
+    double feedback = 0.0;
+    bool filterIn = false, waveshaperIn = false, compressorIn = false;
+    bool isStatic = false;
+
+    /// Compares everything but the version.
+    bool sameAs(const TapDisplayState& other) const
+    {
+        return tapId == other.tapId && hostSlot == other.hostSlot && timeMs == other.timeMs && mix == other.mix && feedback == other.feedback
+            && filterIn == other.filterIn && waveshaperIn == other.waveshaperIn && compressorIn == other.compressorIn && isStatic == other.isStatic;
+    }
+};
 
-template<class T, int C>
-class MultiDlyDisplayStateManager : public MultiDlyDisplayStateManagerBase
+
+/**
+ @brief The bridge the editors see between the engine and themselves: a versioned snapshot of every tap's state.
+
+ The engine publishes a snapshot at the end of every block in which a tap changed. There are two snapshot buffers, and the engine always writes the one the generation counter doesn't point at, then moves the counter over to it, so publishing never waits for a reader. Each buffer has its own sequence number, odd while it is being written, so a reader which is still looking at a buffer when the engine comes round to it again two publishes later notices and tries again. Publishing is a copy of a few kilobytes, and only happens when something changed.
+
+ Readers poll getGeneration(), which is a single load, and only look further when it moves. Each tap has its own version, so readTapIfChanged() lets a component copy out and redraw only the taps which actually changed, rather than copying the whole snapshot every frame.
+
+ The processor holds the manager belonging to its current engine. Only one thread may read it, normally the message thread.
+ */
+class MultiDlyDisplayStateManagerBase
 {
 public:
-    MultiDlyDisplayStateManager();
-    ~MultiDlyDisplayStateManager();
+    virtual ~MultiDlyDisplayStateManagerBase() = default;
+
+    /// @brief Gets the number of publishes so far. A reader with nothing newer than this needn't look at anything else.
+    uint32 getGeneration() const { return generation.load(std::memory_order_acquire); }
+
+    /**
+     @brief Copies a tap's state into dest if its version isn't knownVersion, and updates knownVersion to match.
+
+     Returns false, leaving dest alone, if the tap hasn't changed since knownVersion, which for a slot that has never held a tap is 0.
+
+     @param index The engine's index of the tap, in [0, DISPLAY_STATE_MAX_TAPS).
+     @param dest Where to copy the tap's state to.
+     @param knownVersion The version the reader already has.
+     */
+    bool readTapIfChanged(int index, TapDisplayState& dest, uint32& knownVersion) const;
 
-    bool AddNewTap();
-    
+protected:
 
+    /// Gets the state the next publish() will hand over, to be filled in. Audio thread only.
+    TapDisplayState& getPendingTap(int index) { return pending[(size_t) index]; }
+
+    /// Hands over the pending state if any tap changed since the last publish, bumping the versions of the ones which did. Never allocates or blocks. Audio thread only.
+    void publish() noexcept;
 
 private:
 
+    struct Snapshot
+    {
+        std::atomic<uint32> sequence { 0 }; // odd while being written
+        std::array<TapDisplayState, DISPLAY_STATE_MAX_TAPS> taps;
+    };
+
+    std::array<Snapshot, 2> snapshots;
+    std::atomic<uint32> generation { 0 }; // snapshots[generation & 1] is the newest
+
+    std::array<TapDisplayState, DISPLAY_STATE_MAX_TAPS> pending, published; // audio thread only
+    uint32 nextVersion = 1;
+};
 
 
+/**
+ @brief The MultiDlyDisplayStateManager for a particular engine, which knows how to read its taps.
+
+ Created and owned by the MultiDlyEngine, which calls publish() at the end of every block.
+ */
+template<class T, int C>
+class MultiDlyDisplayStateManager : public MultiDlyDisplayStateManagerBase
+{
+public:
+    MultiDlyDisplayStateManager();
+    ~MultiDlyDisplayStateManager() override;
+
+    /// @brief Publishes the state of the engine's taps. Audio thread only.
+    void publish(const std::array<std::shared_ptr<MultiDlyTap<T, C>>, DISPLAY_STATE_MAX_TAPS>& taps) noexcept;
+
+private:
 
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiDlyDisplayStateManager)
 };
@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    MultiDlyHistoryPyramid.cpp
+    Created: 19 Oct 2026 8:41:53pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#include "MultiDlyHistoryPyramid.h"
+
+
+MultiDlyHistoryPyramid::MultiDlyHistoryPyramid(int _historyLength) : historyLength(_historyLength)
+{
+    int numBins = (historyLength + HISTORY_BASE_BIN_SAMPLES - 1) / HISTORY_BASE_BIN_SAMPLES;
+
+    for (;;)
+    {
+        levels.emplace_back(new std::atomic<uint32>[(size_t) numBins]);
+        levelSizes.push_back(numBins);
+
+        for (int i = 0; i < numBins; ++i) levels.back()[(size_t) i].store(emptyBin);
+
+        if (numBins == 1) break;
+        numBins = (numBins + 1) / 2;
+    }
+
+    for (auto& m : markers) m.store(-1);
+}
+
+
+MultiDlyHistoryPyramid::Range MultiDlyHistoryPyramid::unpack(uint32 bin) noexcept
+{
+    auto toValue = [] (uint32 q) { return ((float) q / 32767.5f - 1.0f) * HISTORY_RANGE; };
+
+    Range r;
+    if (bin == emptyBin) return r;
+
+    r.min = toValue(bin & 0xffffu);
+    r.max = toValue(bin >> 16);
+    return r;
+}
+
+
+void MultiDlyHistoryPyramid::updateParents(int firstBin, int lastBin) noexcept
+{
+    for (size_t level = 1; level < levels.size(); ++level)
+    {
+        firstBin /= 2;
+        lastBin /= 2;
+
+        const auto& children = levels[level - 1];
+        const int numChildren = levelSizes[level - 1];
+
+        for (int bin = firstBin; bin <= lastBin; ++bin)
+        {
+            uint32 packed = children[(size_t) (2 * bin)].load(std::memory_order_relaxed);
+            if (2 * bin + 1 < numChildren) packed = merge(packed, children[(size_t) (2 * bin + 1)].load(std::memory_order_relaxed));
+
+            levels[level][(size_t) bin].store(packed, std::memory_order_relaxed);
+        }
+    }
+}
+
+
+uint32 MultiDlyHistoryPyramid::mergeSpan(int level, int start, int end) const noexcept
+{
+    uint32 packed = emptyBin;
+    if (start >= end) return packed;
+
+    const int binSamples = getBinSamples(level);
+    const int lastBin = jmin(levelSizes[(size_t) level] - 1, (end - 1) / binSamples);
+
+    for (int bin = start / binSamples; bin <= lastBin; ++bin)
+    {
+        packed = merge(packed, levels[(size_t) level][(size_t) bin].load(std::memory_order_relaxed));
+    }
+
+    return packed;
+}
+
+
+void MultiDlyHistoryPyramid::getColumns(Range* dest, int numColumns, int64 spanSamples) const
+{
+    if (numColumns <= 0) return;
+
+    const int64 written = getNumSamplesWritten();
+    const int64 available = jmin(written, (int64) historyLength);
+    const int64 head = written % historyLength; // one past the newest sample
+    const double samplesPerColumn = (double) spanSamples / numColumns;
+
+    // the coarsest level which still has a bin per column
+    int level = 0;
+    while (level + 1 < getNumLevels() && getBinSamples(level + 1) <= samplesPerColumn) ++level;
+
+    for (int col = 0; col < numColumns; ++col)
+    {
+        // how far behind the head the column starts and ends, oldest first
+        const auto ageStart = (int64) (spanSamples - col * samplesPerColumn);
+        const auto ageEnd = jmax((int64) 0, (int64) (spanSamples - (col + 1) * samplesPerColumn));
+
+        if (ageEnd >= available)
+        {
+            dest[col] = Range();
+            continue;
+        }
+
+        int64 start = head - jmin(ageStart, available);
+        int64 end = head - ageEnd;
+        if (start < 0) { start += historyLength; end += historyLength; }
+
+        uint32 packed;
+
+        if (end <= historyLength)
+        {
+            packed = mergeSpan(level, (int) start, (int) end);
+        }
+        else
+        {
+            packed = merge(mergeSpan(level, (int) start, historyLength), mergeSpan(level, 0, (int) (end - historyLength)));
+        }
+
+        dest[col] = unpack(packed);
+    }
+}
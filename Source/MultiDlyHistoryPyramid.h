@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    MultiDlyHistoryPyramid.h
+    Created: 19 Oct 2026 8:41:53pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#define HISTORY_BASE_BIN_SAMPLES 64 // the samples summarised by each bin of the finest level
+#define HISTORY_RANGE 2.0f // bins are stored over [-HISTORY_RANGE, HISTORY_RANGE], and anything beyond is pinned to the edge
+#define HISTORY_MAX_MARKERS 32 // must be at least MAX_NUM_DLY_TAPS
+
+#include <JuceHeader.h>
+
+
+/**
+ @brief A multi-resolution min/max summary of an engine's delay history, for drawing it.
+
+ The finest level holds the range of every HISTORY_BASE_BIN_SAMPLES samples of the circular buffer, taken over all channels, and each level above it merges pairs of bins from the one below, up to a single bin for the whole buffer. The engine calls write() with each chunk once it is final, which only touches the bins the chunk covers and their parents, so keeping the pyramid up to date costs a pass over the chunk plus a few bins per level.
+
+ The editor reads it with getColumns(), which picks the coarsest level that still has at least one bin per column, so drawing the whole history costs a few bins per pixel no matter how long the buffer is.
+
+ Each bin is a single atomic word of two 16-bit values, so the audio thread writes it with one relaxed store and a reader never sees half a bin. A reader can still see a column part way through an update, which is only ever one chunk stale.
+ */
+class MultiDlyHistoryPyramid
+{
+public:
+
+    /// The range of a run of samples. An empty range, for history which hasn't been written yet, has min > max.
+    struct Range
+    {
+        float min = 1.0f, max = -1.0f;
+
+        bool isEmpty() const { return min > max; }
+    };
+
+    /**
+     @brief Constructor. Allocates every level, empty.
+
+     @param _historyLength The length of the circular buffer being summarised, in samples.
+     */
+    MultiDlyHistoryPyramid(int _historyLength);
+
+    /// @brief Gets the length of the circular buffer being summarised, in samples.
+    int getHistoryLength() const { return historyLength; }
+
+    /// @brief Gets the number of levels, the finest being level 0.
+    int getNumLevels() const { return (int) levels.size(); }
+
+    /// @brief Gets the number of samples each bin of a level summarises.
+    static int getBinSamples(int level) { return HISTORY_BASE_BIN_SAMPLES << level; }
+
+    /// @brief Gets the number of samples written so far, which is where the newest sample is once wrapped to the buffer.
+    int64 getNumSamplesWritten() const { return samplesWritten.load(std::memory_order_acquire); }
+
+
+    /**
+     @brief Summarises a run of newly written history. Never allocates or blocks.
+
+     Runs must be written in order, each starting where the last one ended, and must not wrap around the end of the buffer; split a wrapping run in two. A bin whose first sample is in the run was last written a whole lap ago, so it is started afresh rather than merged with.
+
+     @param startIndex The index in the circular buffer of the first sample of the run.
+     @param channels One pointer per channel to the run's samples.
+     @param numChannels The number of channels.
+     @param numSamples The number of samples in the run.
+     */
+    template <class T>
+    void write(int startIndex, const T* const* channels, int numChannels, int numSamples) noexcept
+    {
+        jassert(startIndex >= 0 && startIndex + numSamples <= historyLength);
+
+        if (numSamples <= 0) return;
+
+        const int firstBin = startIndex / HISTORY_BASE_BIN_SAMPLES;
+        const int lastBin = (startIndex + numSamples - 1) / HISTORY_BASE_BIN_SAMPLES;
+
+        for (int bin = firstBin; bin <= lastBin; ++bin)
+        {
+            const int binStart = bin * HISTORY_BASE_BIN_SAMPLES;
+            const int start = jmax(startIndex, binStart);
+            const int end = jmin(startIndex + numSamples, binStart + HISTORY_BASE_BIN_SAMPLES);
+
+            T lo = std::numeric_limits<T>::max(), hi = std::numeric_limits<T>::lowest();
+
+            for (int chan = 0; chan < numChannels; ++chan)
+            {
+                const T* s = channels[chan] + (start - startIndex);
+
+                for (int i = 0; i < end - start; ++i)
+                {
+                    lo = jmin(lo, s[i]);
+                    hi = jmax(hi, s[i]);
+                }
+            }
+
+            uint32 packed = pack((float) lo, (float) hi);
+
+            // the rest of this bin was written earlier in this lap
+            if (start != binStart) packed = merge(packed, levels[0][(size_t) bin].load(std::memory_order_relaxed));
+
+            levels[0][(size_t) bin].store(packed, std::memory_order_relaxed);
+        }
+
+        updateParents(firstBin, lastBin);
+
+        samplesWritten.fetch_add(numSamples, std::memory_order_release);
+    }
+
+
+    /**
+     @brief Fills dest with the range of each of numColumns equal slices of the newest spanSamples samples of history, oldest first.
+
+     Each column is made from the coarsest level with at least one bin per column, so this costs a few bins per column however long the span is. Columns holding history that hasn't been written yet are empty.
+     */
+    void getColumns(Range* dest, int numColumns, int64 spanSamples) const;
+
+
+    /// @brief Sets where a tap currently reads from, in samples behind the write index, or -1 if there is no tap at that index. Called by the audio thread.
+    void setMarker(int index, int delaySamples) noexcept { markers[(size_t) index].store(delaySamples, std::memory_order_relaxed); }
+
+    /// @brief Gets a marker set by setMarker(), or -1 if there isn't one.
+    int getMarker(int index) const noexcept { return markers[(size_t) index].load(std::memory_order_relaxed); }
+
+private:
+
+    static constexpr uint32 emptyBin = 0x0000ffffu; // min at the top of the range and max at the bottom, which any merge replaces
+
+    /// Packs a range into a bin, rounding outwards so that quantising never makes a peak look smaller.
+    static uint32 pack(float lo, float hi) noexcept
+    {
+        auto quantise = [] (float v) { return jlimit(0.0f, 65535.0f, (v / HISTORY_RANGE + 1.0f) * 32767.5f); };
+
+        const auto qlo = (uint32) std::floor(quantise(lo));
+        const auto qhi = (uint32) std::ceil(quantise(hi));
+        return (qhi << 16) | qlo;
+    }
+
+    static Range unpack(uint32 bin) noexcept;
+
+    static uint32 merge(uint32 a, uint32 b) noexcept
+    {
+        return (jmax(a >> 16, b >> 16) << 16) | jmin(a & 0xffffu, b & 0xffffu);
+    }
+
+    /// Recomputes the bins above bins [firstBin, lastBin] of level 0.
+    void updateParents(int firstBin, int lastBin) noexcept;
+
+    /// Merges the bins of one level covering samples [start, end) of the buffer, which must not wrap.
+    uint32 mergeSpan(int level, int start, int end) const noexcept;
+
+    const int historyLength;
+    std::vector<std::unique_ptr<std::atomic<uint32>[]>> levels;
+    std::vector<int> levelSizes;
+    std::atomic<int64> samplesWritten { 0 };
+    std::array<std::atomic<int>, HISTORY_MAX_MARKERS> markers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiDlyHistoryPyramid)
+};
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    MultiDlyHistoryResampler.cpp
+    Created: 20 Oct 2026 1:52:36am
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#include "MultiDlyHistoryResampler.h"
+
+
+/// The zeroth order modified Bessel function of the first kind, which the Kaiser window is built from.
+static double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+
+    // the series converges quickly for the arguments a window needs
+    for (int k = 1; k < 32; ++k)
+    {
+        const double t = x / (2.0 * k);
+        term *= t * t;
+        sum += term;
+        if (term < sum * 1.0e-12) break;
+    }
+
+    return sum;
+}
+
+
+MultiDlyHistoryResampler::MultiDlyHistoryResampler()
+    : table((size_t) tableSize, 0.0)
+{
+    const double beta = RESAMPLE_KAISER_BETA;
+    const double norm = besselI0(beta);
+
+    for (int i = 0; i < tableSize; ++i)
+    {
+        const double x = (double) i / RESAMPLE_TABLE_RESOLUTION; // in zero crossings
+        const double r = x / RESAMPLE_HALF_ZERO_CROSSINGS;
+        if (r >= 1.0) break; // the window is zero from here on
+
+        const double sinc = i == 0 ? 1.0 : std::sin(MathConstants<double>::pi * x) / (MathConstants<double>::pi * x);
+        table[(size_t) i] = sinc * besselI0(beta * std::sqrt(1.0 - r * r)) / norm;
+    }
+
+    setRatio(1.0);
+}
+
+
+void MultiDlyHistoryResampler::setRatio(double sourceToDestRatio) noexcept
+{
+    jassert(sourceToDestRatio > 0.0);
+
+    // going down in rate, the kernel is stretched so it also removes what is above the new Nyquist frequency
+    cutoff = RESAMPLE_PASSBAND * jmin(1.0, 1.0 / sourceToDestRatio);
+    reach = RESAMPLE_HALF_ZERO_CROSSINGS / cutoff;
+    tableScale = RESAMPLE_TABLE_RESOLUTION * cutoff;
+}
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    MultiDlyHistoryResampler.h
+    Created: 20 Oct 2026 1:52:36am
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#define RESAMPLE_HALF_ZERO_CROSSINGS 16 // the number of sinc lobes either side of the centre of the kernel
+#define RESAMPLE_TABLE_RESOLUTION 512 // kernel values stored per zero crossing; the rest are linearly interpolated
+#define RESAMPLE_KAISER_BETA 8.0 // about 80dB of stopband attenuation
+#define RESAMPLE_PASSBAND 0.95 // the cutoff, as a fraction of the lower of the two Nyquist frequencies
+
+#include <JuceHeader.h>
+
+
+/**
+ @brief Reads a block of audio recorded at one sample rate at arbitrary positions, as if it had been recorded at another.
+
+ Each output sample is a Kaiser-windowed sinc interpolation of the source around a fractional position. When the new rate is lower than the old one, the kernel is stretched so its cutoff falls below the new Nyquist frequency, so content that can no longer be represented is filtered out rather than aliased. The kernel is tabulated once, so one sample costs one multiply-add and one table lookup per source sample within the kernel's reach.
+
+ This is far too slow for the audio thread; it is meant for the one-off conversion of the engine's delay history when the sample rate changes, on the background thread.
+ */
+class MultiDlyHistoryResampler
+{
+public:
+
+    /// @brief Constructor. Builds the kernel table.
+    MultiDlyHistoryResampler();
+
+
+    /**
+     @brief Sets the conversion.
+
+     @param sourceToDestRatio The source sample rate divided by the destination sample rate, which is also how far the source position moves for each destination sample.
+     */
+    void setRatio(double sourceToDestRatio) noexcept;
+
+
+    /**
+     @brief Gets the value of the source at a fractional position, band-limited for the destination rate.
+
+     Source samples outside [0, numSourceSamples) count as silence.
+
+     @param source The source samples.
+     @param numSourceSamples The number of source samples.
+     @param position Where to read, in source samples.
+     */
+    template <class T>
+    T getSample(const T* source, int numSourceSamples, double position) const noexcept
+    {
+        const int first = jmax(0, (int) std::ceil(position - reach));
+        const int last = jmin(numSourceSamples - 1, (int) std::floor(position + reach));
+
+        double sum = 0.0;
+
+        for (int m = first; m <= last; ++m)
+        {
+            // where this source sample falls in the table
+            const double x = std::abs(position - m) * tableScale;
+            const int i = (int) x;
+            if (i >= tableSize - 1) continue;
+
+            const double frac = x - i;
+            sum += (double) source[m] * (table[(size_t) i] + frac * (table[(size_t) i + 1] - table[(size_t) i]));
+        }
+
+        return (T) (sum * cutoff);
+    }
+
+private:
+
+    static constexpr int tableSize = RESAMPLE_HALF_ZERO_CROSSINGS * RESAMPLE_TABLE_RESOLUTION + 2;
+
+    std::vector<double> table; // the windowed sinc at [0, RESAMPLE_HALF_ZERO_CROSSINGS] zero crossings, and one past the end
+
+    double cutoff = RESAMPLE_PASSBAND; // as a fraction of the source's Nyquist frequency
+    double reach = RESAMPLE_HALF_ZERO_CROSSINGS; // how far either side of a position the kernel reaches, in source samples
+    double tableScale = RESAMPLE_TABLE_RESOLUTION; // table entries per source sample
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiDlyHistoryResampler)
+};
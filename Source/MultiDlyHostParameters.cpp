@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    MultiDlyHostParameters.cpp
+    Created: 20 Oct 2026 12:31:05am
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#include "MultiDlyHostParameters.h"
+
+
+MultiDlyHostParameters::MultiDlyHostParameters(AudioProcessor& processor)
+{
+    firstParameterIndex = processor.getParameters().size();
+
+    for (auto& v : syncValues) v.store(-1.0f, std::memory_order_relaxed);
+
+    for (int tap = 0; tap < MAX_NUM_DLY_TAPS; ++tap)
+    {
+        for (int p = 0; p < numTapParameters; ++p)
+        {
+            const TapParameterInfo& info = getTapParameterInfo((TapParameter) p);
+            const String id = "tap" + String(tap + 1) + "_" + info.id;
+            const String name = "Tap " + String(tap + 1) + " " + info.name;
+
+            RangedAudioParameter* parameter = nullptr;
+
+            switch (info.kind)
+            {
+                case TapParameterInfo::Choice:
+                    parameter = new AudioParameterChoice(id, name, { "Sine", "Tanh", "Signum" }, roundToInt(info.defaultValue));
+                    break;
+
+                case TapParameterInfo::Toggle:
+                    parameter = new AudioParameterBool(id, name, info.defaultValue >= 0.5f);
+                    break;
+
+                case TapParameterInfo::Continuous:
+                default:
+                    parameter = new AudioParameterFloat(id, name, info.range, info.defaultValue, info.label);
+                    break;
+            }
+
+            processor.addParameter(parameter);
+            parameters.add(parameter);
+            parameter->addListener(this);
+        }
+    }
+}
+
+MultiDlyHostParameters::~MultiDlyHostParameters()
+{
+    for (auto* p : parameters) p->removeListener(this);
+}
+
+
+void MultiDlyHostParameters::parameterValueChanged(int parameterIndex, float newValue)
+{
+    const int index = parameterIndex - firstParameterIndex;
+    if (! isPositiveAndBelow(index, parameters.size())) return;
+
+    // the engine already has what syncFromState() is writing, but anything else is a real change
+    if (newValue == syncValues[(size_t) index].load()) return;
+
+    // replaces any earlier change to this parameter that the audio thread hasn't taken yet
+    changes.set(index, parameters.getUnchecked(index)->convertFrom0to1(newValue));
+}
+
+
+RangedAudioParameter* MultiDlyHostParameters::getParameter(int slot, TapParameter parameter) const
+{
+    if (! isPositiveAndBelow(slot, MAX_NUM_DLY_TAPS)) return nullptr;
+
+    return parameters[slot * numTapParameters + (int) parameter];
+}
+
+
+void MultiDlyHostParameters::dispatchChanges(EngineBase& engine) noexcept
+{
+    // When a change arrived says nothing about where in the block it belongs: the wrappers deliver a block's automation
+    // just before processBlock(), and an offline render runs faster than real time. So everything lands at the start.
+    changes.takeChanges([&engine] (int index, float value)
+    {
+        engine.queueParameterEvent({ 0, index / numTapParameters, (TapParameter) (index % numTapParameters), value });
+    });
+}
+
+
+void MultiDlyHostParameters::syncFromState(const void* data, size_t sizeInBytes)
+{
+    StateHeader header;
+    if (! readStateHeader(data, sizeInBytes, header)) return;
+
+    // the same slots the engine gives the records when it loads them
+    const int numTaps = (int) jmin(header.numTaps, (uint32) MAX_NUM_DLY_TAPS);
+    std::array<int, MAX_NUM_DLY_TAPS> slots;
+    std::array<int, MAX_NUM_DLY_TAPS> recordInSlot;
+    recordInSlot.fill(-1);
+
+    for (int i = 0; i < numTaps; ++i) slots[(size_t) i] = readTapRecord(data, header, i).slot;
+    assignTapSlots(slots.data(), numTaps, MAX_NUM_DLY_TAPS);
+    for (int i = 0; i < numTaps; ++i) recordInSlot[(size_t) slots[(size_t) i]] = i;
+
+    for (int tap = 0; tap < MAX_NUM_DLY_TAPS; ++tap)
+    {
+        // slots with no saved tap are given a default record
+        const int i = recordInSlot[(size_t) tap];
+        const TapRecord record = i >= 0 ? readTapRecord(data, header, i) : TapRecord();
+
+        for (int p = 0; p < numTapParameters; ++p)
+        {
+            const int index = tap * numTapParameters + p;
+            auto* parameter = parameters.getUnchecked(index);
+            const float value = parameter->convertTo0to1(getTapRecordValue(record, (TapParameter) p));
+
+            // the listener is called from inside setValueNotifyingHost(), so the value only needs marking for the call
+            syncValues[(size_t) index].store(value);
+            parameter->setValueNotifyingHost(value);
+            syncValues[(size_t) index].store(-1.0f);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    MultiDlyHostParameters.h
+    Created: 20 Oct 2026 12:31:05am
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "multiDlyEngine.h"
+#include "MultiDlyParameterTable.h"
+
+
+/**
+ @brief Exposes every parameter of every tap slot to the host, and turns the host's changes into timestamped TapParameterEvents for the engine.
+
+ There is one set of TapParameters for each of the engine's MAX_NUM_DLY_TAPS tap slots, named "Tap 1 Time" and so on. Slot n drives the tap whose MultiDlyTap::getHostSlot() is n, which it keeps however the taps are re-sorted by time and through a save and load, so automation stays with its tap. A change to a slot with no tap in it is ignored.
+
+ JUCE doesn't pass the host's sample offsets for parameter changes through to the processor, and its plugin wrappers apply a block's automation just before calling processBlock(), so there is no timing within the block to recover. dispatchChanges() therefore hands every change that arrived since the last block to the engine at the start of the coming block, with no added latency. The engine's TapParameterEvent offsets are there for a source which does know where within a block a change falls.
+
+ Changes go through a MultiDlyParameterTable, so however many times a parameter changes between two blocks, only its latest value reaches the engine. A dragged slider or dense automation therefore costs the engine at most one event per parameter per block, and restarts a tap's time ramp at most once per block.
+ */
+class MultiDlyHostParameters : private AudioProcessorParameter::Listener
+{
+public:
+
+    /**
+     @brief Constructor. Adds the parameters to the processor, so must be called from its constructor before any other parameters are added.
+
+     @param processor The processor to add the parameters to.
+     */
+    explicit MultiDlyHostParameters(AudioProcessor& processor);
+
+    /// @brief Destructor. Stops listening to the parameters, which the processor still owns.
+    ~MultiDlyHostParameters() override;
+
+
+    /**
+     @brief Hands the changes that have arrived since the last call to the engine as events at the start of the coming block.
+
+     Must be called from the audio thread, once per block, before the engine's processBlock(). Never allocates or blocks.
+
+     @param engine The engine to queue the events with.
+     */
+    void dispatchChanges(EngineBase& engine) noexcept;
+
+    /**
+     @brief Moves every parameter to the value it has in a block written by EngineBase::getState(), so the host sees the state that was loaded.
+
+     Each record goes to the slot saved with it, or, in a state from before slots were saved, to the slot the engine gives it. The changes aren't sent back to the engine, as it already has them. Slots with no tap in the state go back to their defaults. Must be called from the message thread.
+     */
+    void syncFromState(const void* data, size_t sizeInBytes);
+
+    /**
+     @brief Gets one parameter of a tap slot, or nullptr if the slot is out of range.
+
+     This is how the editor changes a tap: with `beginChangeGesture()`, `setValueNotifyingHost()` and `endChangeGesture()` on the parameter, like any other control bound to a host parameter. The host records the change, and it reaches the engine through dispatchChanges() like the host's own, so the parameters always hold every tap's settings.
+
+     @param slot The tap's host slot, see MultiDlyTap::getHostSlot().
+     @param parameter Which of the tap's parameters to get.
+     */
+    RangedAudioParameter* getParameter(int slot, TapParameter parameter) const;
+
+private:
+
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int, bool) override {}
+
+    Array<RangedAudioParameter*> parameters; // [tap * numTapParameters + parameter], owned by the processor
+    int firstParameterIndex = 0; // the processor's index of parameters[0]
+
+    MultiDlyParameterTable<MAX_NUM_DLY_TAPS * numTapParameters> changes; // the latest value of each parameter the audio thread hasn't taken yet
+    // the normalised value syncFromState() is writing to each parameter, or -1, so the listener can tell the sync's own
+    // change from one the host makes at the same time
+    std::array<std::atomic<float>, MAX_NUM_DLY_TAPS * numTapParameters> syncValues;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiDlyHostParameters)
+};
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    MultiDlyMeters.h
+    Created: 19 Oct 2026 8:02:17pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#define METERED_TAPS 32 // must be at least MAX_NUM_DLY_TAPS
+#define METERED_CHANNELS 24 // the widest layout createMultiDlyEngine() supports
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+
+/**
+ @brief The levels of an engine's taps and its input and output over one host block.
+
+ Published by the engine through a TripleBuffer after every block, and read with EngineBase::getLatestLevels(). A tap's level is of its wet output, before it is mixed with the dry signal, taken over all of its channels. Static taps being run through the convolver can't be told apart, so they read as silent while that's happening.
+ */
+struct LevelSnapshot
+{
+    struct Level
+    {
+        float peak = 0.0f;
+        float rms = 0.0f;
+    };
+
+    struct Tap
+    {
+        const void* tapId = nullptr; ///< the MultiDlyTap this level belongs to, for matching up with the UI's taps; never dereferenced
+        Level level;
+    };
+
+    std::array<Tap, METERED_TAPS> taps {};
+    int numTaps = 0;
+
+    std::array<Level, METERED_CHANNELS> input {}, output {};
+    int numChannels = 0;
+
+    int64 blockIndex = 0; ///< which block of the engine's life this is, so a reader can tell a fresh snapshot from an old one
+};
+
+
+/**
+ @brief Adds a run of samples to a running peak and sum of squares, in a single pass.
+
+ @param samples The samples to measure.
+ @param numSamples The number of samples.
+ @param peak The running peak, which is raised to the largest absolute sample if that is higher.
+ @param sumOfSquares The running sum of squares, which every sample's square is added to.
+ */
+inline void accumulateLevel(const float* samples, int numSamples, float& peak, float& sumOfSquares) noexcept
+{
+    int i = 0;
+
+   #if JUCE_INTEL
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 peaks = _mm_setzero_ps(), sums = _mm_setzero_ps();
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const __m128 v = _mm_loadu_ps(samples + i);
+        peaks = _mm_max_ps(peaks, _mm_and_ps(v, absMask));
+        sums = _mm_add_ps(sums, _mm_mul_ps(v, v));
+    }
+
+    alignas(16) float p[4], s[4];
+    _mm_store_ps(p, peaks);
+    _mm_store_ps(s, sums);
+
+    peak = jmax(peak, jmax(p[0], p[1]), jmax(p[2], p[3]));
+    sumOfSquares += (s[0] + s[1]) + (s[2] + s[3]);
+   #endif
+
+    for (; i < numSamples; ++i)
+    {
+        peak = jmax(peak, std::abs(samples[i]));
+        sumOfSquares += samples[i] * samples[i];
+    }
+}
+
+/// @brief The same as the float version, for double engines.
+inline void accumulateLevel(const double* samples, int numSamples, float& peak, float& sumOfSquares) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        peak = jmax(peak, (float) std::abs(samples[i]));
+        sumOfSquares += (float) (samples[i] * samples[i]);
+    }
+}
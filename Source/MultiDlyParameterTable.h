@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    MultiDlyParameterTable.h
+    Created: 20 Oct 2026 1:14:47am
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+/**
+ @brief Coalesces changes to a fixed set of parameters from any number of writer threads, for one reader to apply.
+
+ Each parameter has one slot holding its latest value, and a bit in a dirty mask. set() overwrites the slot and sets the bit, so any number of changes to the same parameter between two reads cost the reader a single update, and a burst of changes can never overflow anything. The reader clears a whole word of the mask at a time and only visits the parameters whose bits were set, so its cost depends on how many parameters changed, not on how many there are or how often they changed.
+
+ Neither side allocates or locks, so the reader can be an audio thread. A write that races with the read of its slot just marks the parameter dirty again, so the reader always ends up with the latest value.
+
+ @tparam Size The number of parameters.
+ */
+template <int Size>
+class MultiDlyParameterTable
+{
+public:
+
+    /// @brief Constructor. Every parameter starts clean.
+    MultiDlyParameterTable()
+    {
+        for (auto& w : dirty) w.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     @brief Records a new value for a parameter, replacing any the reader hasn't taken yet. Safe to call from any number of threads at once.
+
+     @param index The parameter, in the range [0, Size).
+     @param value The new value.
+     */
+    void set(int index, float value) noexcept
+    {
+        jassert(isPositiveAndBelow(index, Size));
+
+        values[(size_t) index].store(value, std::memory_order_relaxed);
+        dirty[(size_t) index / 32].fetch_or(1u << (index % 32), std::memory_order_release);
+    }
+
+    /**
+     @brief Calls `function(index, value)` once for every parameter set since the last call, with its latest value, and marks them clean. Must only be called from one thread.
+
+     Parameters are visited in index order, not the order they were set in.
+     */
+    template <class Function>
+    void takeChanges(Function&& function) noexcept
+    {
+        for (int word = 0; word < numWords; ++word)
+        {
+            // cleared before the slots are read, so a change made while they are being read is seen next time
+            uint32 bits = dirty[(size_t) word].exchange(0, std::memory_order_acquire);
+
+            while (bits != 0)
+            {
+                const int bit = findHighestSetBit(bits & (0u - bits)); // the lowest set bit, on its own
+                bits &= bits - 1;
+
+                const int index = word * 32 + bit;
+                function(index, values[(size_t) index].load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+private:
+
+    static constexpr int numWords = (Size + 31) / 32;
+
+    std::array<std::atomic<float>, Size> values {};
+    std::array<std::atomic<uint32>, numWords> dirty;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiDlyParameterTable)
+};
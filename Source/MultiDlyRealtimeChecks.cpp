@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+
+    MultiDlyRealtimeChecks.cpp
+    Created: 19 Oct 2026 4:05:31pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#include "MultiDlyRealtimeChecks.h"
+
+#if MULTIDLY_REALTIME_CHECKS
+
+#define REALTIME_CHECK_MAX_FRAMES 64
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if ! JUCE_WINDOWS
+ #include <execinfo.h>
+ #include <unistd.h>
+#endif
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <time.h>
+#endif
+
+#if JUCE_WINDOWS
+ #define REALTIME_CHECK_TLS thread_local
+#else
+ // initial-exec, so that reading the flags can never itself allocate, even from inside malloc
+ #define REALTIME_CHECK_TLS thread_local __attribute__((tls_model("initial-exec")))
+#endif
+
+// plain ints rather than objects, so they're constant-initialised and need no guard or destructor
+static REALTIME_CHECK_TLS int realtimeDepth = 0;
+static REALTIME_CHECK_TLS int suspendDepth = 0;
+
+static std::atomic<int> numViolations { 0 };
+static std::atomic<bool> abortOnViolation { false };
+
+
+MultiDlyRealtimeChecks::ScopedRealtime::ScopedRealtime() noexcept { ++realtimeDepth; }
+MultiDlyRealtimeChecks::ScopedRealtime::~ScopedRealtime() noexcept { --realtimeDepth; }
+
+MultiDlyRealtimeChecks::ScopedNonRealtime::ScopedNonRealtime() noexcept { ++suspendDepth; }
+MultiDlyRealtimeChecks::ScopedNonRealtime::~ScopedNonRealtime() noexcept { --suspendDepth; }
+
+bool MultiDlyRealtimeChecks::isCheckingThisThread() noexcept { return realtimeDepth > 0 && suspendDepth == 0; }
+
+int MultiDlyRealtimeChecks::getNumViolations() noexcept { return numViolations.load(); }
+
+void MultiDlyRealtimeChecks::resetNumViolations() noexcept { numViolations.store(0); }
+
+void MultiDlyRealtimeChecks::setAbortOnViolation(bool shouldAbort) noexcept { abortOnViolation.store(shouldAbort); }
+
+
+void MultiDlyRealtimeChecks::check(const char* what) noexcept
+{
+    if (! isCheckingThisThread()) return;
+
+    ++numViolations;
+
+    // reporting writes and may allocate, none of which should be reported again
+    ScopedNonRealtime suspend;
+
+   #if JUCE_WINDOWS
+    std::fprintf(stderr, "MultiDly realtime violation: %s\n", what);
+   #else
+    static const char prefix[] = "MultiDly realtime violation: ";
+    write(STDERR_FILENO, prefix, sizeof(prefix) - 1);
+    write(STDERR_FILENO, what, std::strlen(what));
+    write(STDERR_FILENO, "\n", 1);
+
+    // backtrace_symbols_fd() writes straight to the descriptor, without allocating
+    void* frames[REALTIME_CHECK_MAX_FRAMES];
+    const int numFrames = backtrace(frames, REALTIME_CHECK_MAX_FRAMES);
+    backtrace_symbols_fd(frames, numFrames, STDERR_FILENO);
+   #endif
+
+    if (abortOnViolation.load()) std::abort();
+}
+
+
+//==============================================================================
+#if JUCE_LINUX
+
+// glibc's own entry points, so the allocator can be wrapped without looking anything up
+extern "C" void* __libc_malloc(size_t);
+extern "C" void* __libc_calloc(size_t, size_t);
+extern "C" void* __libc_realloc(void*, size_t);
+extern "C" void* __libc_memalign(size_t, size_t);
+extern "C" void __libc_free(void*);
+
+/// Finds the next definition of a function after ours. The pointer is cached in a constant-initialised atomic, which unlike a dynamically initialised static needs no guard, as the guard could itself take a lock.
+template <class Function>
+static Function nextDefinition(std::atomic<void*>& cache, const char* name) noexcept
+{
+    void* f = cache.load(std::memory_order_relaxed);
+
+    if (f == nullptr)
+    {
+        f = dlsym(RTLD_NEXT, name);
+        cache.store(f, std::memory_order_relaxed);
+    }
+
+    return reinterpret_cast<Function>(f);
+}
+
+#define REALTIME_CHECK_FORWARD(returnType, name, params, args)                                      \
+    extern "C" returnType name params                                                               \
+    {                                                                                               \
+        MultiDlyRealtimeChecks::check(#name);                                                       \
+        static std::atomic<void*> next { nullptr };                                                 \
+        return nextDefinition<returnType (*) params>(next, #name) args;                             \
+    }
+
+extern "C" void* malloc(size_t size)
+{
+    MultiDlyRealtimeChecks::check("malloc");
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t num, size_t size)
+{
+    MultiDlyRealtimeChecks::check("calloc");
+    return __libc_calloc(num, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size)
+{
+    MultiDlyRealtimeChecks::check("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    MultiDlyRealtimeChecks::check("posix_memalign");
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr == nullptr ? ENOMEM : 0;
+}
+
+extern "C" void* aligned_alloc(size_t alignment, size_t size)
+{
+    MultiDlyRealtimeChecks::check("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void free(void* ptr)
+{
+    if (ptr != nullptr) MultiDlyRealtimeChecks::check("free");
+    __libc_free(ptr);
+}
+
+REALTIME_CHECK_FORWARD(int, pthread_mutex_lock, (pthread_mutex_t* m), (m))
+REALTIME_CHECK_FORWARD(int, pthread_rwlock_rdlock, (pthread_rwlock_t* l), (l))
+REALTIME_CHECK_FORWARD(int, pthread_rwlock_wrlock, (pthread_rwlock_t* l), (l))
+REALTIME_CHECK_FORWARD(int, sem_wait, (sem_t* s), (s))
+REALTIME_CHECK_FORWARD(int, nanosleep, (const struct timespec* req, struct timespec* rem), (req, rem))
+REALTIME_CHECK_FORWARD(int, usleep, (useconds_t usec), (usec))
+
+#else
+
+// elsewhere the C allocator can't be replaced this simply, so C++ allocation is checked at operator new instead.
+void* operator new(std::size_t size)
+{
+    MultiDlyRealtimeChecks::check("operator new");
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    MultiDlyRealtimeChecks::check("operator new[]");
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    MultiDlyRealtimeChecks::check("operator new");
+    return std::malloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    MultiDlyRealtimeChecks::check("operator new[]");
+    return std::malloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (ptr != nullptr) MultiDlyRealtimeChecks::check("operator delete");
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    if (ptr != nullptr) MultiDlyRealtimeChecks::check("operator delete[]");
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { operator delete[](ptr); }
+
+#endif
+
+#endif
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    MultiDlyRealtimeChecks.h
+    Created: 19 Oct 2026 4:05:31pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifndef MULTIDLY_REALTIME_CHECKS
+ #define MULTIDLY_REALTIME_CHECKS 0 // set by the MULTIDLY_REALTIME_CHECKS CMake option
+#endif
+
+#include <JuceHeader.h>
+
+#if MULTIDLY_REALTIME_CHECKS
+
+/**
+ @brief Debug instrumentation which reports anything a realtime thread does that could block it: heap allocation and freeing, taking a lock, or sleeping.
+
+ Realtime code is marked with MULTIDLY_REALTIME_SCOPE, which sets a thread-local flag for the rest of the scope. While that flag is set, the global `operator new` and `operator delete` are checked everywhere. On Linux, `malloc` and its relatives, `pthread_mutex_lock`, the rwlock locks, `sem_wait`, `nanosleep` and `usleep` are checked too. Every violation is counted and printed to stderr with a stack trace, and, if abortOnViolation() is set, aborts the process, so that a test run fails where the violation happened.
+
+ The interceptors replace the C library's functions by defining them, so they only take effect in executables: the Standalone build and any test or tool linking the plugin's sources. A plugin loaded into a host gets the host's allocator.
+
+ Only exists when built with the `MULTIDLY_REALTIME_CHECKS` CMake option, and MULTIDLY_REALTIME_SCOPE compiles to nothing otherwise.
+ */
+class MultiDlyRealtimeChecks
+{
+public:
+
+    /// Marks the current thread as running realtime code for the lifetime of this object. Scopes nest.
+    class ScopedRealtime
+    {
+    public:
+        ScopedRealtime() noexcept;
+        ~ScopedRealtime() noexcept;
+    };
+
+    /// Suspends checking on the current thread for the lifetime of this object, for calls that are known and accepted. Scopes nest.
+    class ScopedNonRealtime
+    {
+    public:
+        ScopedNonRealtime() noexcept;
+        ~ScopedNonRealtime() noexcept;
+    };
+
+    /// @brief Gets whether the current thread is in realtime code, and not in a ScopedNonRealtime.
+    static bool isCheckingThisThread() noexcept;
+
+    /// @brief Gets the number of violations reported since the process started or resetNumViolations() was last called.
+    static int getNumViolations() noexcept;
+
+    /// @brief Sets the violation count back to zero.
+    static void resetNumViolations() noexcept;
+
+    /// @brief Sets whether a violation should abort the process once it's been reported.
+    static void setAbortOnViolation(bool shouldAbort) noexcept;
+
+    /// @brief Counts and reports a violation, if the current thread is being checked. Called by the interceptors.
+    static void check(const char* what) noexcept;
+};
+
+ #define MULTIDLY_REALTIME_SCOPE MultiDlyRealtimeChecks::ScopedRealtime multiDlyRealtimeScope;
+
+#else
+
+ #define MULTIDLY_REALTIME_SCOPE
+
+#endif
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    MultiDlyStageArena.cpp
+    Created: 19 Oct 2026 3:12:48pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#include "MultiDlyStageArena.h"
+#include "MultiDlyTap.h"
+
+template<class T, int C>
+MultiDlyStageArena<T, C>::MultiDlyStageArena()
+{
+    freeAllSlots(freeFilters);
+    freeAllSlots(freeCompressors);
+
+    for (auto& f : filters)
+    {
+        f.lp.setType(dsp::StateVariableTPTFilterType::lowpass);
+        f.hp.setType(dsp::StateVariableTPTFilterType::highpass);
+    }
+}
+
+
+template<class T, int C>
+void MultiDlyStageArena<T, C>::prepare(double sampleRate)
+{
+    // C * 2 channels, because the feedback signal is processed separately from the regular signal.
+    const dsp::ProcessSpec spec { sampleRate, MAX_BLOCK_SIZE, C * 2 };
+
+    for (auto& f : filters)
+    {
+        f.lp.prepare(spec);
+        f.hp.prepare(spec);
+    }
+
+    for (auto& c : compressors) c.prepare(spec);
+}
+
+
+template<class T, int C>
+int MultiDlyStageArena<T, C>::claimSlot(FreeMask& freeSlots) noexcept
+{
+    for (int word = 0; word < slotWords; ++word)
+    {
+        uint64 free = freeSlots[word].load();
+
+        while (free != 0)
+        {
+            int bit = 0;
+            while ((free & ((uint64) 1 << bit)) == 0) ++bit;
+
+            if (freeSlots[word].compare_exchange_weak(free, free & ~((uint64) 1 << bit))) return word * 64 + bit;
+        }
+    }
+
+    numFailedAcquires.fetch_add(1, std::memory_order_relaxed);
+    return -1;
+}
+
+template<class T, int C>
+void MultiDlyStageArena<T, C>::freeAllSlots(FreeMask& freeSlots) noexcept
+{
+    for (int word = 0; word < slotWords; ++word)
+    {
+        const int slotsInWord = jmin(64, STAGE_ARENA_SLOTS - word * 64);
+        freeSlots[word].store(slotsInWord == 64 ? ~(uint64) 0 : ((uint64) 1 << slotsInWord) - 1);
+    }
+}
+
+
+template<class T, int C>
+typename MultiDlyStageArena<T, C>::FilterStage* MultiDlyStageArena<T, C>::acquireFilters() noexcept
+{
+    const int slot = claimSlot(freeFilters);
+    return slot < 0 ? nullptr : &filters[slot];
+}
+
+template<class T, int C>
+void MultiDlyStageArena<T, C>::release(FilterStage* stage) noexcept
+{
+    const auto slot = (int) (stage - filters.data());
+    jassert(slot >= 0 && slot < STAGE_ARENA_SLOTS);
+
+    freeFilters[slot / 64].fetch_or((uint64) 1 << (slot % 64));
+}
+
+
+template<class T, int C>
+typename MultiDlyStageArena<T, C>::CompressorStage* MultiDlyStageArena<T, C>::acquireCompressor() noexcept
+{
+    const int slot = claimSlot(freeCompressors);
+    return slot < 0 ? nullptr : &compressors[slot];
+}
+
+template<class T, int C>
+void MultiDlyStageArena<T, C>::release(CompressorStage* stage) noexcept
+{
+    const auto slot = (int) (stage - compressors.data());
+    jassert(slot >= 0 && slot < STAGE_ARENA_SLOTS);
+
+    freeCompressors[slot / 64].fetch_or((uint64) 1 << (slot % 64));
+}
+
+
+// the same channel counts as createMultiDlyEngine()
+template class MultiDlyStageArena<float, 1>;
+template class MultiDlyStageArena<float, 2>;
+template class MultiDlyStageArena<float, 4>;
+template class MultiDlyStageArena<float, 6>;
+template class MultiDlyStageArena<float, 8>;
+template class MultiDlyStageArena<float, 12>;
+template class MultiDlyStageArena<float, 16>;
+template class MultiDlyStageArena<float, 24>;
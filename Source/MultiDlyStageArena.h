@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    MultiDlyStageArena.h
+    Created: 19 Oct 2026 3:12:48pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#define STAGE_ARENA_SLOTS 96 // one of each stage for every tap in the engine's pool, which can all be holding theirs at once, so must be at least TAP_POOL_SIZE
+
+#include <JuceHeader.h>
+
+
+/**
+ @brief The preallocated state for the optional DSP stages of an engine's taps.
+
+ Most taps never enable their filters or compressor, so rather than every tap owning prepared processors for `C * 2` channels, a tap borrows a stage from its engine's arena only while that stage is enabled. The stages are created and prepared with the engine, and are claimed and returned with a single atomic operation, so taps can pick them up and hand them back on the audio thread without allocating or locking. Stages in use are all kept together in one block, which keeps the audio thread's working set to the state of the stages actually running.
+
+ @tparam T The engine's processing type
+ @tparam C The number of channels
+ */
+template <class T, int C>
+class MultiDlyStageArena
+{
+public:
+
+    /// A tap's pair of filters, which are always enabled and disabled together.
+    struct FilterStage
+    {
+        dsp::StateVariableTPTFilter<T> lp, hp;
+    };
+
+    /// A tap's compressor.
+    using CompressorStage = dsp::Compressor<T>;
+
+
+    /// @brief Constructor. Sets up the filters' types; call prepare() before use.
+    MultiDlyStageArena();
+
+
+    /**
+     @brief Prepares every stage, in use or not, for a sample rate.
+
+     This may allocate, so must not be called while audio is running. The stages' parameters aren't kept, so taps need to apply theirs again afterwards.
+
+     @param sampleRate The engine's sampling rate, in Hz.
+     */
+    void prepare(double sampleRate);
+
+
+    /// @brief Claims a filter stage, returning nullptr if every one is in use. Never allocates or blocks.
+    FilterStage* acquireFilters() noexcept;
+
+    /// @brief Returns a filter stage claimed by acquireFilters().
+    void release(FilterStage* stage) noexcept;
+
+    /// @brief Claims a compressor, returning nullptr if every one is in use. Never allocates or blocks.
+    CompressorStage* acquireCompressor() noexcept;
+
+    /// @brief Returns a compressor claimed by acquireCompressor().
+    void release(CompressorStage* stage) noexcept;
+
+
+    /// @brief Gets how many times a stage couldn't be claimed because every one was in use. The tap runs without that stage until one is free, so anything above zero is a bug worth reporting.
+    uint32 getNumFailedAcquires() const noexcept { return numFailedAcquires.load(std::memory_order_relaxed); }
+
+private:
+
+    static constexpr int slotWords = (STAGE_ARENA_SLOTS + 63) / 64;
+    using FreeMask = std::array<std::atomic<uint64>, slotWords>; // a set bit means that slot is free
+
+    /// Claims the lowest set bit of a free mask, returning its index or -1 if there are none.
+    int claimSlot(FreeMask& freeSlots) noexcept;
+
+    /// Marks every slot of a free mask free.
+    static void freeAllSlots(FreeMask& freeSlots) noexcept;
+
+    std::array<FilterStage, STAGE_ARENA_SLOTS> filters;
+    std::array<CompressorStage, STAGE_ARENA_SLOTS> compressors;
+
+    FreeMask freeFilters, freeCompressors;
+    std::atomic<uint32> numFailedAcquires { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiDlyStageArena)
+};
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    MultiDlyStateFormat.cpp
+    Created: 19 Oct 2026 11:04:36pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#include "MultiDlyStateFormat.h"
+#include "multiDlyEngine.h"
+
+
+bool readStateHeader(const void* data, size_t sizeInBytes, StateHeader& header)
+{
+    // the first fields are the same in every schema, so they can be read before the header's size is known
+    const size_t minimumHeaderSize = offsetof(StateHeader, flags) + sizeof(uint32);
+    if (data == nullptr || sizeInBytes < minimumHeaderSize) return false;
+
+    StateHeader h;
+    std::memcpy(&h, data, jmin(sizeInBytes, sizeof(StateHeader)));
+
+    if (h.magic != STATE_MAGIC || h.headerSize < minimumHeaderSize || h.headerSize > sizeInBytes || h.recordSize == 0) return false;
+
+    // an older, smaller header than ours is followed by its records, which mustn't be read as header fields
+    if (h.headerSize < sizeof(StateHeader))
+    {
+        h = StateHeader();
+        std::memcpy(&h, data, h.headerSize);
+    }
+
+    if ((uint64) h.headerSize + (uint64) h.numTaps * h.recordSize > sizeInBytes) return false;
+
+    header = h;
+    return true;
+}
+
+
+void assignTapSlots(int* slots, int numTaps, int numSlots) noexcept
+{
+    jassert(numTaps <= numSlots && numSlots <= 64);
+
+    uint64 taken = 0;
+
+    for (int i = 0; i < numTaps; ++i)
+    {
+        const uint64 bit = isPositiveAndBelow(slots[i], numSlots) ? (uint64) 1 << slots[i] : 0;
+
+        if (bit == 0 || (taken & bit) != 0) slots[i] = -1;
+        else taken |= bit;
+    }
+
+    int next = 0;
+
+    for (int i = 0; i < numTaps; ++i)
+    {
+        if (slots[i] >= 0) continue;
+
+        while (next < numSlots && (taken & ((uint64) 1 << next)) != 0) ++next;
+        if (next == numSlots) break;
+
+        slots[i] = next;
+        taken |= (uint64) 1 << next;
+    }
+}
+
+
+#if MULTIDLY_STATE_BENCHMARK
+String runStateBenchmark()
+{
+    auto engine = createMultiDlyEngine<float>(2, 48000.0, 512);
+    if (engine == nullptr) return "no engine";
+
+    // every tap gets different settings, so neither path can get away with sharing anything
+    Random random(1);
+    MemoryBlock block;
+
+    {
+        ValueTree state("MultiDlyState");
+
+        for (int t = 0; t < MAX_NUM_DLY_TAPS; ++t)
+        {
+            state.appendChild(ValueTree("MultiDlyTap", {{"hpFilterFreq", 20.0 + random.nextDouble() * 200.0}, {"lpFilterFreq", 2000.0 + random.nextDouble() * 18000.0},
+                                                         {"hpFilterRes", 0.70710678}, {"lpFilterRes", 0.70710678}, {"compRatio", 1.0 + random.nextDouble() * 4.0},
+                                                         {"compThresh", -random.nextDouble() * 30.0}, {"compAtk", 1.0}, {"compRel", 100.0}, {"compIn", random.nextBool()},
+                                                         {"wsType", 1}, {"wsPreGain", 1.0}, {"wsPostGain", 1.0}, {"wsIn", random.nextBool()}, {"compFdbk", false},
+                                                         {"wsFdbk", false}, {"filtPre", random.nextBool()}, {"filtIn", true}, {"mix", random.nextDouble()},
+                                                         {"feedback", random.nextDouble() * 0.9}, {"timeMs", random.nextDouble() * MAX_DELAY_TIME_SECONDS * 1000.0}}), nullptr);
+        }
+
+        engine->setStateFromValueTree(state);
+    }
+
+    auto time = [] (std::function<void()> f)
+    {
+        const int64 start = Time::getHighResolutionTicks();
+        for (int i = 0; i < STATE_BENCHMARK_ITERATIONS; ++i) f();
+        return Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1.0e6 / STATE_BENCHMARK_ITERATIONS;
+    };
+
+    const double binarySave = time([&] { engine->getState(block); });
+    const size_t binarySize = block.getSize();
+    const double binaryLoad = time([&] { engine->setState(block.getData(), block.getSize()); });
+
+    const double xmlSave = time([&] { AudioProcessor::copyXmlToBinary(*engine->getStateAsValueTree().createXml(), block); });
+    const size_t xmlSize = block.getSize();
+    const double xmlLoad = time([&]
+    {
+        if (auto xml = AudioProcessor::getXmlFromBinary(block.getData(), (int) block.getSize()))
+            engine->setStateFromValueTree(ValueTree::fromXml(*xml));
+    });
+
+    return "state benchmark, " + String(MAX_NUM_DLY_TAPS) + " taps:\n"
+         + "  binary:         save " + String(binarySave, 2) + " us, load " + String(binaryLoad, 2) + " us, " + String((int) binarySize) + " bytes\n"
+         + "  ValueTree XML:  save " + String(xmlSave, 2) + " us, load " + String(xmlLoad, 2) + " us, " + String((int) xmlSize) + " bytes";
+}
+#endif
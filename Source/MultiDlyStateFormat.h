@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    MultiDlyStateFormat.h
+    Created: 19 Oct 2026 11:04:36pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifndef MULTIDLY_STATE_BENCHMARK
+ #define MULTIDLY_STATE_BENCHMARK 0 // set for the MultiDlyTests target only
+#endif
+
+#define STATE_MAGIC 0x594c444du // "MDLY" in the first four bytes of the block
+#define STATE_SCHEMA_VERSION 2 // 2 added TapRecord::slot
+#define STATE_BENCHMARK_ITERATIONS 1000
+
+#include <JuceHeader.h>
+
+#if ! JUCE_LITTLE_ENDIAN
+ #error "The binary state format is written in the host's byte order, which is assumed to be little endian"
+#endif
+
+
+/**
+ @brief The binary plugin state, as written by EngineBase::getState().
+
+ A block is a StateHeader followed by numTaps TapRecords of recordSize bytes each. Each record is a fixed layout of plain fields, so saving is a single allocation plus a copy per tap, and loading is a copy per tap with no lookups by name.
+
+ The format only ever grows: a newer schema may add fields to the end of the header or of each record, but never moves or reinterprets an existing one. Readers go by the headerSize and recordSize in the block, not by their own structs, so an older build skips fields it doesn't know about and a newer build gives fields an older block doesn't have their defaults.
+ */
+struct StateHeader
+{
+    enum Flags : uint32
+    {
+        CrossChannelFeedback = 1 << 0
+    };
+
+    uint32 magic = STATE_MAGIC;
+    uint32 schemaVersion = STATE_SCHEMA_VERSION; ///< the newest schema the writer knew about
+    uint32 headerSize = 0; ///< the size of the header, in bytes, as written
+    uint32 recordSize = 0; ///< the size of each TapRecord, in bytes, as written
+    uint32 numTaps = 0;
+    uint32 flags = 0;
+};
+
+/// @brief One tap, in the binary state. The defaults are those of a freshly reset MultiDlyTap, and are what a field missing from an older record reads as.
+struct TapRecord
+{
+    enum Flags : uint32
+    {
+        CompIn = 1 << 0,
+        CompFdbk = 1 << 1,
+        WSIn = 1 << 2,
+        WSFdbk = 1 << 3,
+        FiltPre = 1 << 4,
+        FiltIn = 1 << 5
+    };
+
+    double timeMs = 0.0;
+    double mix = 0.0;
+    double feedback = 0.0;
+
+    float hpFreq = 20.0f, lpFreq = 20000.0f, hpRes = 0.70710678f, lpRes = 0.70710678f;
+    float compRatio = 1.0f, compThresh = 0.0f, compAtk = 1.0f, compRel = 100.0f;
+    float wsPreGain = 1.0f, wsPostGain = 1.0f;
+    uint32 wsType = 1; // Tanh
+    uint32 flags = 0; // a fresh tap has every stage off
+
+    int32 slot = -1; ///< the host parameter slot the tap is automated through, or -1 for the engine to give it one. Schema 2.
+    uint32 reserved = 0; ///< keeps the record a whole number of doubles long, so there is no uninitialised padding to save
+};
+
+// the layouts are part of the format, so they mustn't change by accident
+static_assert(sizeof(StateHeader) == 24, "StateHeader's layout is part of the saved format");
+static_assert(sizeof(TapRecord) == 80, "TapRecord's layout is part of the saved format");
+
+
+/**
+ @brief Checks whether a block starts with a binary state header that can be read.
+
+ Returns false for anything else, such as the XML that older builds and ValueTree based tools write, so the caller can fall back to reading that.
+
+ @param data The block.
+ @param sizeInBytes The size of the block.
+ @param header Filled in with the block's header if it returns true.
+ */
+bool readStateHeader(const void* data, size_t sizeInBytes, StateHeader& header);
+
+/**
+ @brief Reads record index of a block whose header readStateHeader() accepted, giving any fields the block's records don't have their defaults.
+ */
+inline TapRecord readTapRecord(const void* data, const StateHeader& header, int index) noexcept
+{
+    TapRecord record;
+    const char* src = static_cast<const char*>(data) + header.headerSize + (size_t) index * header.recordSize;
+    std::memcpy(&record, src, jmin((size_t) header.recordSize, sizeof(TapRecord)));
+    return record;
+}
+
+
+/**
+ @brief Gives each of a set of taps its own host parameter slot, so that every tap keeps the slot it was saved with.
+
+ A tap keeps its slot if it is in range and no earlier tap has already taken it. The rest, such as taps from before slots were saved or new taps with -1, take the lowest free slots in order, so an old state maps its taps onto the slots in the order they were saved, as it always did.
+
+ @param slots Each tap's slot, updated in place.
+ @param numTaps The number of taps, which must be no more than numSlots.
+ @param numSlots The number of slots, at most 64.
+ */
+void assignTapSlots(int* slots, int numTaps, int numSlots) noexcept;
+
+
+#if MULTIDLY_STATE_BENCHMARK
+/**
+ @brief Times saving and loading a full engine's state through the binary format and through `ValueTree` XML, returning a report.
+
+ Made for comparing the two paths, so it fills a stereo engine with MAX_NUM_DLY_TAPS taps and runs each path STATE_BENCHMARK_ITERATIONS times. Only built into the MultiDlyTests console app, which runs this with `--state-benchmark`.
+ */
+String runStateBenchmark();
+#endif
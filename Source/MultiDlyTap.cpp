@@ -10,34 +10,30 @@
 
 #include <cmath>
 #include "MultiDlyTap.h"
+#include "multiDlyEngine.h"
 
 
 
 template <class T, int C>
 MultiDlyTap<T, C>::MultiDlyTap(MultiDlyEngine<T, C>& _engine, int _maxWriteIndexOffset) : maxWriteIndexOffset(_maxWriteIndexOffset), engine(_engine)
 {
-    timeMs = 0.;
-    resetSmoothedValue();
+    init();
 }
 
 template<class T, int C>
-MultiDlyTap<T, C>::MultiDlyTap(const MultiDlyTap& other) : engine(other.engine), maxWriteIndexOffset(other.getMaxWriteIndexOffset())
+MultiDlyTap<T, C>::MultiDlyTap(const MultiDlyTap& other) : maxWriteIndexOffset(other.getMaxWriteIndexOffset()), engine(other.engine)
 {
-    time = other.getTimeMs();
-    resetSmoothedValue();
+    // the processors' state isn't copied, only the parameters, as two taps never share a signal path.
+    init();
+    fromVTWithoutReset(const_cast<MultiDlyTap&>(other).toVT());
 }
 
 
 template<class T, int C>
-MultiDlyTap<T, C>::MultiDlyTap(MultiDlyTap&& other) : engine(other.engine)
+MultiDlyTap<T, C>::MultiDlyTap(MultiDlyTap&& other) : maxWriteIndexOffset(other.getMaxWriteIndexOffset()), engine(other.engine)
 {
-    if (this != &other) // this is a pointer comparison, not a contents comparison
-    {
-//        this->manager = other.manager;
-        this->time = other.time;
-        other.time = 0;
-    }
-    resetSmoothedValue();
+    init();
+    fromVTWithoutReset(other.toVT());
 }
 
 template<class T, int C>
@@ -49,25 +45,120 @@ double MultiDlyTap<T, C>::getSampleRate() const
 template<class T, int C>
 void MultiDlyTap<T, C>::init()
 {
-    timeMs = 0.;
+    prepare();
+    reset();
+}
+
+template<class T, int C>
+void MultiDlyTap<T, C>::prepare()
+{
     sr = engine.getSampleRate();
     resetSmoothedValue();
 
-    lpFilter = std::make_shared<dsp::StateVariableTPTFilter<T>>();
-    hpFilter = std::make_shared<dsp::StateVariableTPTFilter<T>>();
-    comp = std::make_shared<dsp::Compressor<T>>();
-    waveshaper = std::make_shared<dsp::WaveShaper<T>>();
+    // the arena's stages lose their settings when they're prepared for a new rate
+    stageParametersChanged.store(true);
+}
+
+template<class T, int C>
+void MultiDlyTap<T, C>::reset()
+{
+    timeMs.setCurrentAndTargetValue(0.);
+    timeMsTargetValue = 0.;
+    feedback = 0.;
+    mix = 0.;
+
+    compin.store(false);
+    wsin.store(false);
+    compfdbk.store(false);
+    wsfdbk.store(false);
+    filtpre.store(false);
+    filtin.store(false);
+
+    lpFreq = 20000;
+    hpFreq = 20;
+    lpRes = hpRes = (T) (1.0 / MathConstants<double>::sqrt2);
+
+    setCompRatio(1);
+    setCompThresh(0);
+    setCompAtk(1);
+    setCompRel(100);
+
+    setWaveshaperType(Tanh);
+    setWaveshaperPreGain(1.0);
+    setWaveshaperPostGain(1.0);
+
+    hostSlot = -1;
+
+    // stages still held from the tap's last use are returned by the next syncStages(), or kept if they're enabled again
+    if (filters != nullptr)
+    {
+        filters->lp.reset();
+        filters->hp.reset();
+    }
+
+    if (comp != nullptr) comp->reset();
+}
 
-    lpFilter->setType(dsp::StateVariableTPTFilterType::lowpass);
-    hpFilter->setType(dsp::StateVariableTPTFilterType::highpass);
-    lpFilter->prepare({sr, MAX_BLOCK_SIZE, C * 2});
-    hpFilter->prepare({sr, MAX_BLOCK_SIZE, C * 2});
 
-    comp->prepare({sr, MAX_BLOCK_SIZE, C * 2});
-    waveshaper->prepare({sr, MAX_BLOCK_SIZE, 1}); // waveshaper doesn't need multiple channels
+template<class T, int C>
+void MultiDlyTap<T, C>::syncStages(MultiDlyStageArena<T, C>& arena) noexcept
+{
+    bool acquired = false;
 
+    if (filtin.load() && filters == nullptr)
+    {
+        // a stage from the arena still has the last tap's state in it
+        if ((filters = arena.acquireFilters()) != nullptr)
+        {
+            filters->lp.reset();
+            filters->hp.reset();
+            acquired = true;
+        }
+        else jassertfalse; // the arena is sized for every pooled tap, so this tap isn't from the pool, or one was leaked
+    }
+    else if (! filtin.load() && filters != nullptr)
+    {
+        arena.release(filters);
+        filters = nullptr;
+    }
 
+    if (compin.load() && comp == nullptr)
+    {
+        if ((comp = arena.acquireCompressor()) != nullptr)
+        {
+            comp->reset();
+            acquired = true;
+        }
+        else jassertfalse;
+    }
+    else if (! compin.load() && comp != nullptr)
+    {
+        arena.release(comp);
+        comp = nullptr;
+    }
+
+    if (stageParametersChanged.exchange(false) || acquired) applyStageParameters();
+}
+
+
+template<class T, int C>
+void MultiDlyTap<T, C>::applyStageParameters() noexcept
+{
+    if (filters != nullptr)
+    {
+        filters->lp.setCutoffFrequency(lpFreq);
+        filters->lp.setResonance(lpRes);
+        filters->hp.setCutoffFrequency(hpFreq);
+        filters->hp.setResonance(hpRes);
+    }
 
+    if (comp != nullptr)
+    {
+        comp->setRatio(compRatio);
+        comp->setThreshold(compThresh);
+        comp->setAttack(compAtk);
+        comp->setRelease(compRel);
+    }
 }
 
 template<class T, int C>
@@ -88,7 +179,9 @@ SmoothedValue<double, ValueSmoothingTypes::Linear>* MultiDlyTap<T, C>::getTimeMs
 template<class T, int C>
 int MultiDlyTap<T, C>::getWriteIndexOffset()
 {
-    return (timeMs.getNextValue() * 1000.0f) * sr;
+    // worked out in double and clamped before the cast, so no setting of the time can overflow the int
+    const double samples = timeMs.getNextValue() * 0.001 * sr;
+    return (int) jlimit(0.0, (double) (maxWriteIndexOffset - 1), std::round(samples));
 }
 
 template<class T, int C>
@@ -127,7 +220,44 @@ void MultiDlyTap<T, C>::setTimeMs(double newTimeMs)
 template<class T, int C>
 void MultiDlyTap<T, C>::setTimeSamples(int newTimeSamples)
 {
-    setTimeMs((newTimeSamples/sr) * 0.001);
+    setTimeMs((double) newTimeSamples * 1000.0 / sr);
+}
+
+template<class T, int C>
+void MultiDlyTap<T, C>::setParameter(TapParameter parameter, float value)
+{
+    const bool on = value >= 0.5f;
+
+    switch (parameter)
+    {
+        case TapParameter::TimeMs:      setTimeMs(value); break;
+        case TapParameter::Mix:         setMix(value); break;
+        case TapParameter::Feedback:    setFeedback(value); break;
+        case TapParameter::HpFreq:      hpFreq = (T) value; stageParametersChanged.store(true); break;
+        case TapParameter::LpFreq:      lpFreq = (T) value; stageParametersChanged.store(true); break;
+        case TapParameter::HpRes:       hpRes = (T) value; stageParametersChanged.store(true); break;
+        case TapParameter::LpRes:       lpRes = (T) value; stageParametersChanged.store(true); break;
+        case TapParameter::CompRatio:   setCompRatio((T) value); break;
+        case TapParameter::CompThresh:  setCompThresh((T) value); break;
+        case TapParameter::CompAtk:     setCompAtk((T) value); break;
+        case TapParameter::CompRel:     setCompRel((T) value); break;
+        case TapParameter::WSPreGain:   setWaveshaperPreGain(value); break;
+        case TapParameter::WSPostGain:  setWaveshaperPostGain(value); break;
+        case TapParameter::WSType:      setWaveshaperType((WaveshaperFunctions) jlimit(0, (int) Signum, roundToInt(value))); break;
+        case TapParameter::CompIn:      setCompIn(on); break;
+        case TapParameter::CompFdbk:    setCompFdbk(on); break;
+        case TapParameter::WSIn:        setWSIn(on); break;
+        case TapParameter::WSFdbk:      setWSFdbk(on); break;
+        case TapParameter::FiltPre:     setFiltPre(on); break;
+        case TapParameter::FiltIn:      setFiltIn(on); break;
+        case TapParameter::NumParameters: jassertfalse; break;
+    }
+}
+
+template<class T, int C>
+void MultiDlyTap<T, C>::skipTimeSmoothing()
+{
+    timeMs.setCurrentAndTargetValue(timeMsTargetValue);
 }
 
 template<class T, int C>
@@ -163,6 +293,9 @@ void MultiDlyTap<T, C>::setWSFdbk(bool wsFdbk) { wsfdbk.store(wsFdbk); }
 template<class T, int C>
 void MultiDlyTap<T, C>::setFiltPre(bool filtPre) { filtpre.store(filtPre); }
 
+template<class T, int C>
+void MultiDlyTap<T, C>::setFiltIn(bool filtIn) { filtin.store(filtIn); }
+
 
 template<class T, int C>
 bool MultiDlyTap<T, C>::getCompIn() { return compin.load(); }
@@ -179,6 +312,16 @@ bool MultiDlyTap<T, C>::getWSFdbk() { return wsfdbk.load(); }
 template<class T, int C>
 bool MultiDlyTap<T, C>::getFiltPre() { return filtpre.load(); }
 
+template<class T, int C>
+bool MultiDlyTap<T, C>::getFiltIn() { return filtin.load(); }
+
+
+template<class T, int C>
+bool MultiDlyTap<T, C>::isStatic()
+{
+    return feedback == 0.0 && ! filtin.load() && ! wsin.load() && ! compin.load() && ! timeMs.isSmoothing();
+}
+
 
 
 template<class T, int C>
@@ -196,7 +339,7 @@ void MultiDlyTap<T, C>::setWaveshaperType(MultiDlyTap<T, C>::WaveshaperFunctions
     }
     else if (newFunctionToUse == Signum)
     {
-        waveshaper.functionToUse = [] (T x) { return (x < 0.0f ? 1 : -1); };
+        waveshaper.functionToUse = [] (T x) { return (x < 0 ? (T) -1 : (T) 1); };
     }
 }
 
@@ -219,7 +362,7 @@ typename MultiDlyTap<T, C>::WaveshaperFunctions MultiDlyTap<T, C>::getWSType() c
 template<class T, int C>
 ValueTree MultiDlyTap<T, C>::toVT()
 {
-    return ValueTree("MultiDlyTap", {{"hpFilterFreq", hpFilter->getCutoffFrequency()}, {"lpFilterFreq", lpFilter->getCutoffFrequency()}, {"hpFilterRes", hpFilter->getResonance()}, {"lpFilterRes", lpFilter->getResonance()}, {"compRatio", compRatio}, {"compThresh", compThresh}, {"compAtk", compAtk}, {"compRel", compRel}, {"compIn", compin.load()}, {"wsType", currentWSFunction}, {"wsPreGain", WSPreGain}, {"wsPostGain", WSPostGain}, {"wsIn", wsin.load()}, {"compFdbk", compfdbk.load()}, {"wsFdbk", wsfdbk.load()}, {"filtPre", filtpre.load()}, {"mix", mix}, {"feedback", feedback}, {"timeMs", timeMsTargetValue}});
+    return ValueTree("MultiDlyTap", {{"hpFilterFreq", hpFreq}, {"lpFilterFreq", lpFreq}, {"hpFilterRes", hpRes}, {"lpFilterRes", lpRes}, {"compRatio", compRatio}, {"compThresh", compThresh}, {"compAtk", compAtk}, {"compRel", compRel}, {"compIn", compin.load()}, {"wsType", currentWSFunction}, {"wsPreGain", WSPreGain}, {"wsPostGain", WSPostGain}, {"wsIn", wsin.load()}, {"compFdbk", compfdbk.load()}, {"wsFdbk", wsfdbk.load()}, {"filtPre", filtpre.load()}, {"filtIn", filtin.load()}, {"mix", mix}, {"feedback", feedback}, {"timeMs", timeMsTargetValue}, {"slot", hostSlot}});
 }
 
 template<class T, int C>
@@ -240,11 +383,13 @@ void MultiDlyTap<T, C>::fromVT(ValueTree vt, MultiDlyEngine<T, C>& engine)
 template<class T, int C>
 void MultiDlyTap<T, C>::fromVTWithoutReset(ValueTree vt)
 {
-    hpFilter->setCutoffFrequency(vt.getProperty("hpFilterFreq"));
-    lpFilter->setCutoffFrequency(vt.getProperty("lpFilterFreq"));
-    hpFilter->setResonance(vt.getProperty("hpFilterRes"));
-    lpFilter->setResonance(vt.getProperty("lpFilterRes"));
+    hpFreq = (T) (double) vt.getProperty("hpFilterFreq");
+    lpFreq = (T) (double) vt.getProperty("lpFilterFreq");
+    hpRes = (T) (double) vt.getProperty("hpFilterRes");
+    lpRes = (T) (double) vt.getProperty("lpFilterRes");
+    stageParametersChanged.store(true);
     setFiltPre(vt.getProperty("filtPre"));
+    setFiltIn(vt.getProperty("filtIn", true)); // trees saved before the filters could be bypassed always had them in
 
     setCompRatio(vt.getProperty("compRatio"));
     setCompAtk(vt.getProperty("compAtk"));
@@ -255,20 +400,81 @@ void MultiDlyTap<T, C>::fromVTWithoutReset(ValueTree vt)
 
     setWSIn(vt.getProperty("wsIn"));
     setWSFdbk(vt.getProperty("wsFdbk"));
-    setWaveshaperType(vt.getProperty("wsType"));
+    setWaveshaperType((WaveshaperFunctions) (int) vt.getProperty("wsType"));
     setWaveshaperPreGain(vt.getProperty("wsPreGain"));
     setWaveshaperPostGain(vt.getProperty("wsPostGain"));
 
     setMix(vt.getProperty("mix"));
     setFeedback(vt.getProperty("feedback"));
     setTimeMs(vt.getProperty("timeMs"));
+
+    hostSlot = vt.getProperty("slot", -1); // the engine checks it, and gives trees from before slots were saved their own
+}
+
+template<class T, int C>
+void MultiDlyTap<T, C>::toRecord(TapRecord& record)
+{
+    record.timeMs = timeMsTargetValue;
+    record.mix = mix;
+    record.feedback = feedback;
+
+    record.hpFreq = (float) hpFreq;
+    record.lpFreq = (float) lpFreq;
+    record.hpRes = (float) hpRes;
+    record.lpRes = (float) lpRes;
+
+    record.compRatio = (float) compRatio;
+    record.compThresh = (float) compThresh;
+    record.compAtk = (float) compAtk;
+    record.compRel = (float) compRel;
+
+    record.wsPreGain = (float) WSPreGain;
+    record.wsPostGain = (float) WSPostGain;
+    record.wsType = (uint32) currentWSFunction;
+
+    record.flags = (compin.load() ? TapRecord::CompIn : 0u) | (compfdbk.load() ? TapRecord::CompFdbk : 0u)
+                 | (wsin.load() ? TapRecord::WSIn : 0u) | (wsfdbk.load() ? TapRecord::WSFdbk : 0u)
+                 | (filtpre.load() ? TapRecord::FiltPre : 0u) | (filtin.load() ? TapRecord::FiltIn : 0u);
+
+    record.slot = hostSlot;
+}
+
+template<class T, int C>
+void MultiDlyTap<T, C>::fromRecordWithoutReset(const TapRecord& record)
+{
+    hpFreq = (T) record.hpFreq;
+    lpFreq = (T) record.lpFreq;
+    hpRes = (T) record.hpRes;
+    lpRes = (T) record.lpRes;
+    stageParametersChanged.store(true);
+    setFiltPre((record.flags & TapRecord::FiltPre) != 0);
+    setFiltIn((record.flags & TapRecord::FiltIn) != 0);
+
+    setCompRatio((T) record.compRatio);
+    setCompAtk((T) record.compAtk);
+    setCompThresh((T) record.compThresh);
+    setCompRel((T) record.compRel);
+    setCompIn((record.flags & TapRecord::CompIn) != 0);
+    setCompFdbk((record.flags & TapRecord::CompFdbk) != 0);
+
+    setWSIn((record.flags & TapRecord::WSIn) != 0);
+    setWSFdbk((record.flags & TapRecord::WSFdbk) != 0);
+    setWaveshaperType(record.wsType <= Signum ? (WaveshaperFunctions) record.wsType : Tanh); // a newer build may have more shapes
+    setWaveshaperPreGain(record.wsPreGain);
+    setWaveshaperPostGain(record.wsPostGain);
+
+    setMix(record.mix);
+    setFeedback(record.feedback);
+    setTimeMs(record.timeMs);
+
+    hostSlot = record.slot;
 }
 
 template<class T, int C>
 void MultiDlyTap<T, C>::setCompRatio(T newRatio)
 {
     compRatio = newRatio;
-    comp->setRatio(newRatio);
+    stageParametersChanged.store(true);
 }
 
 template<class T, int C>
@@ -278,7 +484,7 @@ template<class T, int C>
 void MultiDlyTap<T, C>::setCompThresh(T newThresh)
 {
     compThresh = newThresh;
-    comp->setThresh(newThresh);
+    stageParametersChanged.store(true);
 }
 
 template<class T, int C>
@@ -288,7 +494,7 @@ template<class T, int C>
 void MultiDlyTap<T, C>::setCompAtk(T newAtk)
 {
     compAtk = newAtk;
-    comp->setAtk(newAtk);
+    stageParametersChanged.store(true);
 }
 
 template<class T, int C>
@@ -298,8 +504,19 @@ template<class T, int C>
 void MultiDlyTap<T, C>::setCompRel(T newRel)
 {
     compRel = newRel;
-    comp->setRel(newRel);
+    stageParametersChanged.store(true);
 }
 
 template<class T, int C>
 T MultiDlyTap<T, C>::getCompRel() { return compRel; }
+
+
+// taps are only created by engines, so they need the same instantiations as createMultiDlyEngine().
+template class MultiDlyTap<float, 1>;
+template class MultiDlyTap<float, 2>;
+template class MultiDlyTap<float, 4>;
+template class MultiDlyTap<float, 6>;
+template class MultiDlyTap<float, 8>;
+template class MultiDlyTap<float, 12>;
+template class MultiDlyTap<float, 16>;
+template class MultiDlyTap<float, 24>;
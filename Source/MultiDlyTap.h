@@ -13,6 +13,9 @@
 #define MAX_BLOCK_SIZE 8192
 
 #include <JuceHeader.h>
+#include "MultiDlyStageArena.h"
+#include "MultiDlyStateFormat.h"
+#include "MultiDlyTapParameters.h"
 //#include "MultiDlyDisplayStateManager.h"
 
 template<class T, int Ch> class MultiDlyEngine; // forward declaration fixes this
@@ -23,10 +26,12 @@ template<class T, int C> class MultiDlyDisplayStateManager; // forward declarati
 /// Represents a single tap for the multi-tap delay.
 
 /**
- Represents a single tap for the multi-tap delay, and owns pointers to the tap's processors (comp, lpfilter, hpfilter, and waveshaper).
+ Represents a single tap for the multi-tap delay, and holds the tap's processors (comp, lpfilter, hpfilter, and waveshaper).
 
  While no processing is done directly by this class, some is done through it by calls to the aforementioned processors, so you should be careful to be threadsafe.
 
+ The filters and compressor are only held while they are enabled, and are borrowed from the engine's MultiDlyStageArena. The handover happens on the audio thread in syncStages(), so a setter only ever records the new value; the stage picks it up at the start of the next block.
+
  @tparam T the to use for audio processing
 
  @tparam C the number of channels of audio used for input/output.
@@ -81,12 +86,24 @@ public:
     /// Initializes the tap to default values.
     /**
 
-     Called by all constructors, but can be used externally to return the state to default.
-
-     Note: this specifies that the two filters and compressor should be prepared to handle <em> C * 2 </em> channels, because the feedback signal might need to be processed separately from the regular signal.
+     Called by all constructors, but can be used externally to return the state to default. This is just prepare() followed by reset().
      */
     void init();
 
+    /**
+     @brief Picks up the engine's sample rate.
+
+     The processors themselves are prepared by the engine's MultiDlyStageArena, so this only resets the time smoothing and marks the stages' parameters to be applied again. Parameters are left alone, so it can be called again after a sample rate change without losing the tap's settings. Must only be called off the audio thread.
+     */
+    void prepare();
+
+    /**
+     @brief Returns every parameter to its default and clears the state of any stage the tap still holds.
+
+     Never allocates, so the engine can recycle a pooled tap with this while audio is running, as long as the tap isn't in the engine's list of taps.
+     */
+    void reset();
+
 
     /**
      Sets the time in milliseconds. This uses the internal SmoothedValue timeMs, which ensures that changes are ramped and don't cause audio glitches.
@@ -102,9 +119,14 @@ public:
      */
     void setTimeSamples(int newTimeSamples);
 
+    /// Jumps straight to the time last set, rather than ramping to it. Must only be called while the tap isn't being processed.
+    void skipTimeSmoothing();
+
 
     /**
      Gets the number of samples behind the write pointer to read a sample. This value represents the time, and calls the timeMs SmoothedValue.
+
+     The result is rounded to the nearest sample and clamped to [0, maxWriteIndexOffset).
      */
     int getWriteIndexOffset();
 
@@ -139,7 +161,7 @@ public:
     /**
      Sets the mix for the tap, where 0.0 is no delay, and 1.0 is only delay.
 
-     In the engine, the delayed signal should be multiplied by mix, whereas the dry signal should be multiplied by <em> (1.0 - mix) </em>.
+     In the engine, the delayed signal is multiplied by mix. The dry signal is kept once for all of the taps, multiplied by the average of <em> (1.0 - mix) </em> over them, so a lone tap's mix is a plain wet/dry balance and the dry level doesn't depend on how many taps there are.
 
      @param newMix The new mix value for the tap.
      */
@@ -198,6 +220,33 @@ public:
     void fromVTWithoutReset(ValueTree vt);
 
 
+    /**
+     @brief Writes the tap's state to a fixed-layout record for the binary state format.
+
+     Holds the same as toVT(), but without building a tree or naming anything, so it's a copy of a few dozen bytes.
+
+     @param record The record to fill in.
+     */
+    void toRecord(TapRecord& record);
+
+    /**
+     @brief Sets the tap's state from a record written by toRecord(), keeping its engine and sample rate, like fromVTWithoutReset().
+
+     @param record The record to read.
+     */
+    void fromRecordWithoutReset(const TapRecord& record);
+
+    /**
+     @brief Sets a single parameter through its setter, so a time change ramps as setTimeMs() does and a stage parameter is picked up at the next syncStages().
+
+     Used by the engine to apply TapParameterEvents on the audio thread, so it never allocates.
+
+     @param parameter The parameter to set.
+     @param value The new value, in the units of the parameter's TapParameterInfo::range.
+     */
+    void setParameter(TapParameter parameter, float value);
+
+
     /**
      @brief Sets whether the waveshaper is enabled.
 
@@ -352,49 +401,95 @@ public:
      */
     void setFiltPre(bool filtPre);
 
+
+    /**
+     @brief Sets whether the filters are enabled. They are off on a new tap, so it borrows no filter stage and can run as a static tap until they are turned on.
+
+     @param filtIn The new value for whether the filters should be enabled.
+     */
+    void setFiltIn(bool filtIn);
+
+    /// @brief Gets whether the filters are enabled.
+    bool getFiltIn();
+
+
+    /**
+     @brief Gets whether the tap is currently a plain, static delay: no feedback, no enabled filters, waveshaper or compressor, and a time that isn't ramping.
+
+     The output of such a tap is just the delay history at a fixed offset, scaled by the mix, so the engine can run all of these taps together as a sparse FIR instead of through the per-sample tap machinery. This changes whenever a parameter does, so the engine checks it every block.
+     */
+    bool isStatic();
+
     /**
      @brief Gets the target value of the time SmoothedValue.
      */
     double getTimeMsTargetValue()
     {
-        return timeMsTargetValue();
+        return timeMsTargetValue;
     }
 
     /**
-     As the engine needs to maintain a sorted list of taps in order to achieve proper sub-block feedback values, the MultiDlyTap must provide a call operator which compares the delay time of the two taps.
+     @brief Gets the host parameter slot this tap is automated through, or -1 if it hasn't been given one.
+
+     Unlike its index in the engine's sorted set, which changes whenever the taps are re-sorted by time, a tap keeps its slot for as long as it exists, and the slot is saved with it.
+     */
+    int getHostSlot() const { return hostSlot; }
+
+    /**
+     As the engine needs to maintain a sorted list of taps in order to achieve proper sub-block feedback values, the MultiDlyTap must provide a comparison of the delay time of two taps. Empty slots sort after every tap.
 
      @param a The first tap
      @param b The second tap
      */
-    bool operator ()(MultiDlyTap<T, C> a, MultiDlyTap<T, C> b)
+    static bool compareTimes(const std::shared_ptr<MultiDlyTap<T, C>>& a, const std::shared_ptr<MultiDlyTap<T, C>>& b)
     {
-        return (a.getTimeMsTargetValue() < b.getTimeMsTargetValue());
+        if (a == nullptr || b == nullptr) return b == nullptr && a != nullptr;
+        return (a->getTimeMsTargetValue() < b->getTimeMsTargetValue());
     }
 
 private:
 
-    void resetSmoothedValue();
-    WaveshaperFunctions currentWSFunction;
-    double WSPreGain, WSPostGain;
+    using FilterStage = typename MultiDlyStageArena<T, C>::FilterStage;
+    using CompressorStage = typename MultiDlyStageArena<T, C>::CompressorStage;
 
-    T compRatio, compThresh, compAtk, compRel;
+    /**
+     Called by the engine on the audio thread at the start of every block. Claims a stage from the arena for each newly enabled stage and returns each newly disabled one, then applies any parameters changed since the last block. Never allocates or blocks.
+     */
+    void syncStages(MultiDlyStageArena<T, C>& arena) noexcept;
+
+    /// Applies the stored filter and compressor parameters to whichever stages are held.
+    void applyStageParameters() noexcept;
 
-    double sr, feedback, mix, timeMsTargetValue;
+    void resetSmoothedValue();
 
+    // everything the audio thread reads for a tap without FX is kept together here, ahead of the colder parameters.
+    double feedback = 0.0, mix = 0.0, sr = 44100.0;
     SmoothedValue<double, ValueSmoothingTypes::Linear> timeMs;
+    std::atomic<bool> compin { false }, wsin { false }, compfdbk { false }, wsfdbk { false }, filtpre { false }, filtin { false };
+    FilterStage* filters = nullptr; // only held while filtin, and only changed by syncStages()
+    CompressorStage* comp = nullptr; // only held while compin, and only changed by syncStages()
+    juce::dsp::WaveShaper<T> waveshaper; // just a function pointer, as waveshaping is memoryless, so it's not worth borrowing.
 
-    const int maxWriteIndexOffset;
+    std::atomic<bool> stageParametersChanged { true }; // set by the setters, cleared by syncStages()
+
+    WaveshaperFunctions currentWSFunction = Tanh;
+    double WSPreGain = 1.0, WSPostGain = 1.0;
+
+    T compRatio = 1, compThresh = 0, compAtk = 1, compRel = 100;
+    T lpFreq = 20000, hpFreq = 20, lpRes = (T) 0.70710678, hpRes = (T) 0.70710678;
 
-    std::atomic<bool> compin, wsin, compfdbk, wsfdbk, filtpre;
+    double timeMsTargetValue = 0.0;
 
-    std::shared_ptr<juce::dsp::Compressor<T>> comp;
-    std::shared_ptr<juce::dsp::StateVariableTPTFilter<T>> lpFilter;
-    std::shared_ptr<juce::dsp::StateVariableTPTFilter<T>> hpFilter;
-    std::shared_ptr<juce::dsp::WaveShaper<T>> waveshaper; // can be shared by channels becasue waveshaping is memoryless.
+    const int maxWriteIndexOffset;
 
 //    MultiDlyDisplayStateManager& manager; // is this necessary?
 
     MultiDlyEngine<T, C>& engine; // the engine owns the input samples so it needs a ref here. -- wait it might not.
 
+    int poolSlot = -1; // the slot of the engine's tap pool this tap lives in, or -1 if it was created outside the pool
+    int hostSlot = -1; // see getHostSlot(). Given out by the engine when the tap joins a set.
+
+    friend class MultiDlyEngine<T, C>; // the engine runs the processors directly, and recycles pooled taps
+
 
 };
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    MultiDlyTapParameters.cpp
+    Created: 19 Oct 2026 11:52:18pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#include "MultiDlyTapParameters.h"
+#include "multiDlyEngine.h"
+
+
+const TapParameterInfo& getTapParameterInfo(TapParameter parameter)
+{
+    static const auto infos = []
+    {
+        auto skewed = [] (float start, float end, float centre)
+        {
+            NormalisableRange<float> range(start, end);
+            range.setSkewForCentre(centre);
+            return range;
+        };
+
+        const NormalisableRange<float> unit(0.0f, 1.0f), toggle(0.0f, 1.0f, 1.0f);
+        const auto maxTimeMs = (float) (MAX_DELAY_TIME_SECONDS * 1000);
+
+        // in the same order as TapParameter
+        return std::array<TapParameterInfo, numTapParameters>
+        {{
+            { "time",       "Time",           "ms", TapParameterInfo::Continuous, skewed(0.0f, maxTimeMs, 1000.0f), 0.0f },
+            { "mix",        "Mix",            "",   TapParameterInfo::Continuous, unit, 0.0f },
+            { "feedback",   "Feedback",       "",   TapParameterInfo::Continuous, unit, 0.0f },
+            { "hpFreq",     "HP Freq",        "Hz", TapParameterInfo::Continuous, skewed(20.0f, 20000.0f, 1000.0f), 20.0f },
+            { "lpFreq",     "LP Freq",        "Hz", TapParameterInfo::Continuous, skewed(20.0f, 20000.0f, 1000.0f), 20000.0f },
+            { "hpRes",      "HP Res",         "",   TapParameterInfo::Continuous, skewed(0.1f, 10.0f, 1.0f), 0.70710678f },
+            { "lpRes",      "LP Res",         "",   TapParameterInfo::Continuous, skewed(0.1f, 10.0f, 1.0f), 0.70710678f },
+            { "compRatio",  "Comp Ratio",     ":1", TapParameterInfo::Continuous, skewed(1.0f, 20.0f, 4.0f), 1.0f },
+            { "compThresh", "Comp Threshold", "dB", TapParameterInfo::Continuous, NormalisableRange<float>(-60.0f, 0.0f), 0.0f },
+            { "compAtk",    "Comp Attack",    "ms", TapParameterInfo::Continuous, skewed(0.1f, 200.0f, 10.0f), 1.0f },
+            { "compRel",    "Comp Release",   "ms", TapParameterInfo::Continuous, skewed(1.0f, 2000.0f, 100.0f), 100.0f },
+            { "wsPreGain",  "WS Pre Gain",    "",   TapParameterInfo::Continuous, skewed(0.0f, 10.0f, 1.0f), 1.0f },
+            { "wsPostGain", "WS Post Gain",   "",   TapParameterInfo::Continuous, skewed(0.0f, 10.0f, 1.0f), 1.0f },
+            { "wsType",     "WS Type",        "",   TapParameterInfo::Choice,     NormalisableRange<float>(0.0f, 2.0f, 1.0f), 1.0f },
+            { "compIn",     "Comp On",        "",   TapParameterInfo::Toggle,     toggle, 0.0f },
+            { "compFdbk",   "Comp Feedback",  "",   TapParameterInfo::Toggle,     toggle, 0.0f },
+            { "wsIn",       "WS On",          "",   TapParameterInfo::Toggle,     toggle, 0.0f },
+            { "wsFdbk",     "WS Feedback",    "",   TapParameterInfo::Toggle,     toggle, 0.0f },
+            { "filtPre",    "Filter Pre",     "",   TapParameterInfo::Toggle,     toggle, 0.0f },
+            { "filtIn",     "Filter On",      "",   TapParameterInfo::Toggle,     toggle, 0.0f }
+        }};
+    }();
+
+    return infos[(size_t) parameter];
+}
+
+
+float getTapRecordValue(const TapRecord& record, TapParameter parameter)
+{
+    auto flag = [&record] (uint32 f) { return (record.flags & f) != 0 ? 1.0f : 0.0f; };
+
+    switch (parameter)
+    {
+        case TapParameter::TimeMs:      return (float) record.timeMs;
+        case TapParameter::Mix:         return (float) record.mix;
+        case TapParameter::Feedback:    return (float) record.feedback;
+        case TapParameter::HpFreq:      return record.hpFreq;
+        case TapParameter::LpFreq:      return record.lpFreq;
+        case TapParameter::HpRes:       return record.hpRes;
+        case TapParameter::LpRes:       return record.lpRes;
+        case TapParameter::CompRatio:   return record.compRatio;
+        case TapParameter::CompThresh:  return record.compThresh;
+        case TapParameter::CompAtk:     return record.compAtk;
+        case TapParameter::CompRel:     return record.compRel;
+        case TapParameter::WSPreGain:   return record.wsPreGain;
+        case TapParameter::WSPostGain:  return record.wsPostGain;
+        case TapParameter::WSType:      return (float) record.wsType;
+        case TapParameter::CompIn:      return flag(TapRecord::CompIn);
+        case TapParameter::CompFdbk:    return flag(TapRecord::CompFdbk);
+        case TapParameter::WSIn:        return flag(TapRecord::WSIn);
+        case TapParameter::WSFdbk:      return flag(TapRecord::WSFdbk);
+        case TapParameter::FiltPre:     return flag(TapRecord::FiltPre);
+        case TapParameter::FiltIn:      return flag(TapRecord::FiltIn);
+        case TapParameter::NumParameters: break;
+    }
+
+    jassertfalse;
+    return 0.0f;
+}
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    MultiDlyTapParameters.h
+    Created: 19 Oct 2026 11:52:18pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#define MAX_PARAMETER_EVENTS_PER_BLOCK 1024 // events beyond this in one block are applied at its start instead
+
+#include <JuceHeader.h>
+#include "MultiDlyStateFormat.h"
+
+
+/// Every parameter of a tap that can be changed on its own, by the host or by the engine's parameter events.
+enum class TapParameter : uint16
+{
+    TimeMs,
+    Mix,
+    Feedback,
+    HpFreq,
+    LpFreq,
+    HpRes,
+    LpRes,
+    CompRatio,
+    CompThresh,
+    CompAtk,
+    CompRel,
+    WSPreGain,
+    WSPostGain,
+    WSType,
+    CompIn,
+    CompFdbk,
+    WSIn,
+    WSFdbk,
+    FiltPre,
+    FiltIn,
+
+    NumParameters
+};
+
+/// The number of TapParameters, as an int.
+constexpr int numTapParameters = (int) TapParameter::NumParameters;
+
+
+/// How a TapParameter is shown to the host.
+struct TapParameterInfo
+{
+    enum Kind { Continuous, Choice, Toggle };
+
+    const char* id; // the suffix of the host parameter's ID, after the tap number
+    const char* name;
+    const char* label;
+    Kind kind;
+    NormalisableRange<float> range; // in the units the tap's setter takes; a choice's range is its index
+    float defaultValue;
+};
+
+/// @brief Gets the host-facing description of a parameter. The defaults match a freshly reset MultiDlyTap.
+const TapParameterInfo& getTapParameterInfo(TapParameter parameter);
+
+/// @brief Gets a parameter's value from a saved tap, in the same units as TapParameterInfo::range.
+float getTapRecordValue(const TapRecord& record, TapParameter parameter);
+
+
+/**
+ @brief A change to one parameter of one tap, at a sample offset within a host block.
+
+ The engine splits its processing at each event's offset, so the change takes effect on exactly that sample. See EngineBase::queueParameterEvent().
+ */
+struct TapParameterEvent
+{
+    int sampleOffset = 0;
+    int tap = 0; // the host slot of the tap, see MultiDlyTap::getHostSlot()
+    TapParameter parameter = TapParameter::TimeMs;
+    float value = 0.0f; // in the same units as TapParameterInfo::range
+};
+
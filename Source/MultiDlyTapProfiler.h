@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    MultiDlyTapProfiler.h
+    Created: 19 Oct 2026 6:02:40pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifndef MULTIDLY_TAP_PROFILING
+ #define MULTIDLY_TAP_PROFILING 0 // set by the MULTIDLY_TAP_PROFILING CMake option
+#endif
+
+#define PROFILED_TAPS 32 // must be at least MAX_NUM_DLY_TAPS
+#define TAP_PROFILE_INTERVAL_CHUNKS 16 // one chunk in this many is profiled
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+
+/// @brief Reads the cheapest timestamp the CPU has. The units are only meaningful relative to each other.
+inline uint64 readCycleCounter() noexcept
+{
+   #if JUCE_INTEL
+    return (uint64) __rdtsc();
+   #elif JUCE_ARM && JUCE_64BIT && ! JUCE_MSVC
+    uint64 ticks;
+    asm volatile ("mrs %0, cntvct_el0" : "=r" (ticks));
+    return ticks;
+   #else
+    return (uint64) Time::getHighResolutionTicks();
+   #endif
+}
+
+
+/**
+ @brief How much time each tap of an engine spent in each of its stages over one profiled chunk.
+
+ Published by the engine through a TripleBuffer when built with MULTIDLY_TAP_PROFILING, and read with EngineBase::getLatestTapCosts(). Times are in readCycleCounter() units, so they are best compared with each other or divided by the sample count, rather than read as absolute times.
+ */
+struct TapCostSnapshot
+{
+    /// The parts of a tap that are timed separately. Read includes the mix and feedback arithmetic.
+    enum Stage { Read, Filter, Waveshaper, Compressor, NumStages };
+
+    struct Tap
+    {
+        const void* tapId = nullptr; ///< the MultiDlyTap these costs belong to, for matching up with the UI's taps; never dereferenced
+        std::array<uint64, NumStages> cycles {};
+        int64 samples = 0; ///< samples times channels processed by the tap
+    };
+
+    std::array<Tap, PROFILED_TAPS> taps {};
+    int numTaps = 0;
+    int64 chunkIndex = 0; ///< which chunk of the engine's life this is, so a reader can tell a fresh snapshot from an old one
+
+    /// @brief Gets the costs as text, one line per tap, for logging.
+    String toString() const
+    {
+        static const char* const stageNames[NumStages] = { "read", "filter", "waveshaper", "compressor" };
+        String s;
+
+        for (int i = 0; i < numTaps; ++i)
+        {
+            s << "tap " << i << ":";
+
+            for (int stage = 0; stage < NumStages; ++stage)
+            {
+                const double perSample = taps[i].samples > 0 ? (double) taps[i].cycles[stage] / taps[i].samples : 0.0;
+                s << " " << stageNames[stage] << " " << String(perSample, 1);
+            }
+
+            s << " cycles/sample over " << taps[i].samples << " samples\n";
+        }
+
+        return s;
+    }
+};
+
+
+/**
+ @brief Times the stages of each tap within one channel group of one chunk.
+
+ Each lap() adds the time since the previous one to a tap's stage. A timer for an unprofiled chunk costs a predictable branch per lap, and without MULTIDLY_TAP_PROFILING the whole class compiles to nothing.
+ */
+class TapStageTimer
+{
+public:
+
+   #if MULTIDLY_TAP_PROFILING
+    explicit TapStageTimer(bool shouldTime) noexcept : active(shouldTime) {}
+
+    bool isActive() const noexcept { return active; }
+
+    /// Starts a lap, without charging the time since the last one to anything.
+    void start() noexcept { if (active) last = readCycleCounter(); }
+
+    /// Charges the time since the last lap to one stage of a tap.
+    void lap(int tap, int stage) noexcept
+    {
+        if (! active) return;
+
+        const uint64 now = readCycleCounter();
+        cycles[tap][stage] += now - last;
+        last = now;
+    }
+
+    /// Splits the time since the last lap evenly between one stage of several taps, for work they share.
+    void lapShared(const int* tapIndices, int numTaps, int stage) noexcept
+    {
+        if (! active || numTaps == 0) return;
+
+        const uint64 now = readCycleCounter();
+        const uint64 share = (now - last) / (uint64) numTaps;
+        for (int i = 0; i < numTaps; ++i) cycles[tapIndices[i]][stage] += share;
+        last = now;
+    }
+
+    uint64 getCycles(int tap, int stage) const noexcept { return cycles[tap][stage]; }
+
+   private:
+    const bool active;
+    uint64 last = 0;
+    std::array<std::array<uint64, TapCostSnapshot::NumStages>, PROFILED_TAPS> cycles {};
+
+   #else
+    explicit TapStageTimer(bool) noexcept {}
+    bool isActive() const noexcept { return false; }
+    void start() noexcept {}
+    void lap(int, int) noexcept {}
+    void lapShared(const int*, int, int) noexcept {}
+    uint64 getCycles(int, int) const noexcept { return 0; }
+   #endif
+};
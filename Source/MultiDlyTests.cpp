@@ -0,0 +1,40 @@
+/*
+  ==============================================================================
+
+    MultiDlyTests.cpp
+    Created: 20 Oct 2026 2:52:18am
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "multiDlyEngine.h"
+#include "MultiDlyRealtimeChecks.h"
+#include "MultiDlyStateFormat.h"
+
+//==============================================================================
+/*
+ The MultiDlyTests console app, which runs engines without a host. The tests are registered with CTest, and the benchmarks are run by hand; see Source/CMakeLists.txt.
+*/
+int main (int argc, char* argv[])
+{
+    ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "Usage:", true);
+
+    app.addCommand({ "--realtime-self-test", "--realtime-self-test", "Runs engines with the realtime checks aborting on the first violation.", {},
+                     [] (const ArgumentList&)
+                     {
+                         // a violation aborts with a stack trace before this returns, so a report is a pass
+                         std::cout << runRealtimeSelfTest() << std::endl;
+                         if (MultiDlyRealtimeChecks::getNumViolations() != 0) ConsoleApplication::fail("realtime violations found");
+                     } });
+
+    app.addCommand({ "--layout-benchmark", "--layout-benchmark", "Times the planar and interleaved delay buffer layouts.", {},
+                     [] (const ArgumentList&) { std::cout << runLayoutBenchmark() << std::endl; } });
+
+    app.addCommand({ "--state-benchmark", "--state-benchmark", "Times saving and loading state in the binary format and as ValueTree XML.", {},
+                     [] (const ArgumentList&) { std::cout << runStateBenchmark() << std::endl; } });
+
+    return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+
+    MultiDlyTracer.cpp
+    Created: 19 Oct 2026 7:10:55pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#include "MultiDlyTracer.h"
+
+#if MULTIDLY_TRACING
+
+std::atomic<MultiDlyTracer*> MultiDlyTracer::instance { nullptr };
+std::atomic<uint32> MultiDlyTracer::generation { 0 };
+
+
+MultiDlyTracer::MultiDlyTracer() : myGeneration(++generation)
+{
+    instance.store(this);
+
+    const String path = SystemStats::getEnvironmentVariable("MULTIDLY_TRACE_FILE", {});
+    if (path.isNotEmpty()) start(File(path));
+}
+
+MultiDlyTracer::~MultiDlyTracer()
+{
+    stop();
+    instance.store(nullptr);
+}
+
+
+bool MultiDlyTracer::start(const File& file)
+{
+    if (recording.load()) return false;
+
+    file.deleteFile();
+    auto stream = std::make_unique<FileOutputStream>(file);
+    if (! stream->openedOk()) return false;
+
+    if (rings == nullptr) rings.reset(new Ring[TRACE_MAX_THREADS]);
+
+    // anything left over from a previous recording belongs to that file, not this one
+    for (int i = 0; i < jmin(numRingsClaimed.load(), TRACE_MAX_THREADS); ++i)
+    {
+        rings[i].readPos.store(rings[i].writePos.load());
+        rings[i].numDropped.store(0);
+    }
+
+    out = std::move(stream);
+    out->writeText("{\"traceEvents\":[\n", false, false, nullptr);
+    firstEventWritten = false;
+    startTicks = Time::getHighResolutionTicks();
+    ticksPerMicrosecond = Time::getHighResolutionTicksPerSecond() / 1.0e6;
+
+    recording.store(true);
+    backgroundThread->addTimeSliceClient(this);
+
+    return true;
+}
+
+
+void MultiDlyTracer::stop()
+{
+    if (! recording.exchange(false)) return;
+
+    // waits for a drain in progress, after which this is the only reader
+    backgroundThread->removeTimeSliceClient(this);
+    drain();
+
+    int64 numDropped = 0;
+    for (int i = 0; i < jmin(numRingsClaimed.load(), TRACE_MAX_THREADS); ++i) numDropped += rings[i].numDropped.load();
+
+    out->writeText("\n],\"otherData\":{\"droppedEvents\":" + String(numDropped) + "}}\n", false, false, nullptr);
+    out->flush();
+    out.reset();
+}
+
+
+bool MultiDlyTracer::isActive() noexcept
+{
+    MultiDlyTracer* tracer = instance.load(std::memory_order_acquire);
+    return tracer != nullptr && tracer->recording.load(std::memory_order_relaxed);
+}
+
+
+void MultiDlyTracer::record(const char* name, int64 startTicks, int64 endTicks) noexcept
+{
+    MultiDlyTracer* tracer = instance.load(std::memory_order_acquire);
+    if (tracer == nullptr || ! tracer->recording.load(std::memory_order_acquire)) return;
+
+    Ring* ring = tracer->getRingForThisThread();
+    if (ring == nullptr) return;
+
+    const uint32 w = ring->writePos.load(std::memory_order_relaxed);
+
+    if (w - ring->readPos.load(std::memory_order_acquire) >= TRACE_RING_EVENTS)
+    {
+        ring->numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring->events[w % TRACE_RING_EVENTS] = { name, startTicks, endTicks };
+    ring->writePos.store(w + 1, std::memory_order_release);
+}
+
+
+MultiDlyTracer::Ring* MultiDlyTracer::getRingForThisThread() noexcept
+{
+    // plain pointers, so they're constant-initialised and reading them never allocates
+    static thread_local Ring* cachedRing = nullptr;
+    static thread_local uint32 cachedGeneration = 0;
+
+    if (cachedGeneration != myGeneration)
+    {
+        const int index = numRingsClaimed.fetch_add(1);
+
+        cachedRing = (index < TRACE_MAX_THREADS ? &rings[index] : nullptr);
+        if (cachedRing != nullptr) cachedRing->threadId = (uint64) (pointer_sized_uint) Thread::getCurrentThreadId();
+
+        cachedGeneration = myGeneration;
+    }
+
+    return cachedRing;
+}
+
+
+void MultiDlyTracer::drain()
+{
+    if (out == nullptr) return;
+
+    const int numRings = jmin(numRingsClaimed.load(), TRACE_MAX_THREADS);
+
+    for (int i = 0; i < numRings; ++i)
+    {
+        Ring& ring = rings[i];
+        const uint32 end = ring.writePos.load(std::memory_order_acquire);
+        uint32 r = ring.readPos.load(std::memory_order_relaxed);
+
+        for (; r != end; ++r)
+        {
+            const Event& e = ring.events[r % TRACE_RING_EVENTS];
+            const double ts = (e.startTicks - startTicks) / ticksPerMicrosecond;
+            const double dur = (e.endTicks - e.startTicks) / ticksPerMicrosecond;
+
+            String line;
+            line << (firstEventWritten ? ",\n" : "")
+                 << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"ts\":" << String(ts, 3) << ",\"dur\":" << String(dur, 3)
+                 << ",\"pid\":1,\"tid\":" << String((int64) ring.threadId) << "}";
+
+            out->writeText(line, false, false, nullptr);
+            firstEventWritten = true;
+        }
+
+        ring.readPos.store(r, std::memory_order_release);
+    }
+
+    out->flush();
+}
+
+
+int MultiDlyTracer::useTimeSlice()
+{
+    drain();
+    return TRACE_WRITE_INTERVAL_MS;
+}
+
+#endif
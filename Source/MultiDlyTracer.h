@@ -0,0 +1,137 @@
+/*
+  ==============================================================================
+
+    MultiDlyTracer.h
+    Created: 19 Oct 2026 7:10:55pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifndef MULTIDLY_TRACING
+ #define MULTIDLY_TRACING 0 // set by the MULTIDLY_TRACING CMake option
+#endif
+
+#define TRACE_MAX_THREADS 64 // threads beyond this many just aren't traced
+#define TRACE_RING_EVENTS 4096 // per thread; events that don't fit before the writer catches up are dropped
+#define TRACE_WRITE_INTERVAL_MS 20
+
+#include <JuceHeader.h>
+#include "MultiDlyBackgroundThread.h"
+
+#if MULTIDLY_TRACING
+
+/**
+ @brief Records timed scopes from any thread, including the audio thread, and writes them out as a Chrome trace-event JSON file.
+
+ The file can be opened in chrome://tracing or https://ui.perfetto.dev, to see what each thread was doing and when, across every instance in the process.
+
+ Each thread writes to its own preallocated ring buffer, claimed the first time it records an event, so recording an event is a clock read and a few plain stores with no locks or allocation. The shared MultiDlyBackgroundThread drains the rings to the file. Each scope is stored as one complete ("X") event with its start and duration, so if a ring fills up before it's drained, whole scopes are dropped rather than the begin or end of one, and the count is written to the trace when it stops.
+
+ Hold a `juce::SharedResourcePointer<MultiDlyTracer>` to keep the tracer alive, and mark code with MULTIDLY_TRACE_SCOPE. If the `MULTIDLY_TRACE_FILE` environment variable is set when the tracer is created, it starts recording to that file straight away. Only exists when built with the `MULTIDLY_TRACING` CMake option; otherwise MULTIDLY_TRACE_SCOPE compiles to nothing.
+ */
+class MultiDlyTracer : private TimeSliceClient
+{
+public:
+
+    /// Times the scope it lives in, and records it as one event when destroyed. Scopes that start before recording does aren't recorded.
+    class ScopedEvent
+    {
+    public:
+        explicit ScopedEvent(const char* _name) noexcept : name(_name), startTicks(isActive() ? Time::getHighResolutionTicks() : 0) {}
+        ~ScopedEvent() noexcept { if (startTicks != 0) record(name, startTicks, Time::getHighResolutionTicks()); }
+
+    private:
+        const char* const name;
+        const int64 startTicks;
+    };
+
+
+    /// Constructor. Starts recording if MULTIDLY_TRACE_FILE is set.
+    MultiDlyTracer();
+
+    /// Destructor. Stops recording, finishing the file.
+    ~MultiDlyTracer() override;
+
+
+    /**
+     @brief Starts recording to a file, replacing it. Does nothing and returns false if already recording or the file can't be opened.
+
+     The ring buffers are allocated the first time this is called, so call it off the audio thread.
+     */
+    bool start(const File& file);
+
+    /// @brief Stops recording, writes out everything still in the rings, and finishes the file.
+    void stop();
+
+    /// @brief Gets whether events are currently being recorded.
+    bool isRecording() const noexcept { return recording.load(); }
+
+
+    /// @brief Gets whether a tracer exists and is recording, from any thread.
+    static bool isActive() noexcept;
+
+    /**
+     @brief Records one complete event on the calling thread, if a tracer exists and is recording.
+
+     @param name The event's name. Only the pointer is stored, so this must be a string literal or otherwise outlive the trace.
+     @param startTicks When the event began, from Time::getHighResolutionTicks().
+     @param endTicks When the event ended, from Time::getHighResolutionTicks().
+     */
+    static void record(const char* name, int64 startTicks, int64 endTicks) noexcept;
+
+private:
+
+    struct Event
+    {
+        const char* name;
+        int64 startTicks, endTicks;
+    };
+
+    /// One thread's events. Only that thread writes, and only the drain reads.
+    struct Ring
+    {
+        std::atomic<uint32> writePos { 0 }, readPos { 0 };
+        std::atomic<uint32> numDropped { 0 };
+        uint64 threadId = 0;
+        std::array<Event, TRACE_RING_EVENTS> events;
+    };
+
+    /// Gets the calling thread's ring, claiming one if it hasn't got one yet, or nullptr if they have all been claimed.
+    Ring* getRingForThisThread() noexcept;
+
+    /// Writes out every event recorded so far. Only called by the background thread, or by stop() once it has been taken off it.
+    void drain();
+
+    /// TimeSliceClient callback, which drains the rings.
+    int useTimeSlice() override;
+
+    static std::atomic<MultiDlyTracer*> instance;
+    static std::atomic<uint32> generation; // bumped for each tracer, so threads know to claim a ring from the new one
+
+    const uint32 myGeneration;
+    std::unique_ptr<Ring[]> rings;
+    std::atomic<int> numRingsClaimed { 0 };
+    std::atomic<bool> recording { false };
+
+    std::unique_ptr<FileOutputStream> out;
+    bool firstEventWritten = false;
+    int64 startTicks = 0;
+    double ticksPerMicrosecond = 1.0;
+
+    juce::SharedResourcePointer<MultiDlyBackgroundThread> backgroundThread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiDlyTracer)
+};
+
+ #define MULTIDLY_TRACE_CONCAT_INNER(a, b) a ## b
+ #define MULTIDLY_TRACE_CONCAT(a, b) MULTIDLY_TRACE_CONCAT_INNER(a, b)
+ #define MULTIDLY_TRACE_SCOPE(name) MultiDlyTracer::ScopedEvent MULTIDLY_TRACE_CONCAT(multiDlyTraceEvent, __LINE__) (name);
+
+#else
+
+ #define MULTIDLY_TRACE_SCOPE(name)
+
+#endif
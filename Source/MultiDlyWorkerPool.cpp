@@ -0,0 +1,246 @@
+/*
+  ==============================================================================
+
+    MultiDlyWorkerPool.cpp
+    Created: 19 Oct 2026 9:02:11am
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#include "MultiDlyWorkerPool.h"
+#include "MultiDlyRealtimeChecks.h"
+#include "MultiDlyTracer.h"
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#else
+ #include <semaphore.h>
+ #include <cerrno>
+#endif
+
+#define WORKER_SPIN_ITERATIONS 2000 // how long a worker keeps looking for work before it goes to sleep
+
+
+MultiDlyWorkerPool::MultiDlyWorkerPool()
+{
+    // leave one core free for the host's audio thread, which also runs tasks from its own jobs.
+    const int numThreads = jmax(1, SystemStats::getNumCpus() - 1);
+
+    for (int i = 0; i < numThreads; ++i)
+    {
+        workers.add(new Worker(*this, i));
+        workers.getLast()->startThread(Thread::realtimeAudioPriority);
+    }
+}
+
+MultiDlyWorkerPool::~MultiDlyWorkerPool()
+{
+    for (auto* w : workers) w->signalThreadShouldExit();
+
+    // every worker is either running, and will see the exit flag, or will be let through by one of these
+    workAvailable.post(workers.size());
+
+    for (auto* w : workers) w->stopThread(1000);
+}
+
+
+void MultiDlyWorkerPool::registerInstance() { ++numRegisteredInstances; }
+
+void MultiDlyWorkerPool::unregisterInstance() { --numRegisteredInstances; }
+
+int MultiDlyWorkerPool::getNumRegisteredInstances() const { return numRegisteredInstances.load(); }
+
+int MultiDlyWorkerPool::getNumThreads() const { return workers.size(); }
+
+
+bool MultiDlyWorkerPool::shouldParallelise(int64 workUnits, int numTasks) const
+{
+    if (numTasks < 2 || workers.isEmpty()) return false;
+
+    // tasks too small to be worth handing to another core
+    if (workUnits / numTasks < MIN_WORK_PER_POOL_TASK) return false;
+
+    // the host is already keeping the cores busy with other instances, so keep CPU flat by staying inline
+    return numRegisteredInstances.load() < SystemStats::getNumCpus();
+}
+
+
+void MultiDlyWorkerPool::run(TaskFunction function, void* context, int numTasks, int64 deadlineTicks)
+{
+    if (numTasks <= 0) return;
+
+    MULTIDLY_TRACE_SCOPE("pool dispatch")
+
+    Job* job = nullptr;
+
+    // only bother looking for a slot if there's time for the workers to help
+    if (Time::getHighResolutionTicks() < deadlineTicks)
+    {
+        for (auto& j : jobs)
+        {
+            int expected = Job::Free;
+            if (j.state.compare_exchange_strong(expected, Job::Filling))
+            {
+                job = &j;
+                break;
+            }
+        }
+    }
+
+    // no slot or no time, so everything runs here.
+    if (job == nullptr)
+    {
+        for (int i = 0; i < numTasks; ++i) function(context, i);
+        return;
+    }
+
+    // nextTask is still parked out of range here, so a worker holding a stale pointer to this slot can't claim
+    // anything until every other field is filled in.
+    job->function = function;
+    job->context = context;
+    job->numTasks = numTasks;
+    job->deadlineTicks = deadlineTicks;
+    job->tasksDone.store(0);
+    job->nextTask.store(0);
+    job->state.store(Job::Active);
+
+    // Wakes as many sleeping workers as there are tasks to share, claiming them first so that no two callers post for
+    // the same worker. Posting never takes a lock, and a worker that has said it's going to sleep but hasn't reached
+    // wait() yet still gets the post, as the semaphore counts.
+    int sleeping = numSleepingWorkers.load();
+    int toWake = 0;
+
+    do
+    {
+        toWake = jmin(sleeping, numTasks - 1);
+    }
+    while (toWake > 0 && ! numSleepingWorkers.compare_exchange_weak(sleeping, sleeping - toWake));
+
+    if (toWake > 0) workAvailable.post(toWake);
+
+    // the caller works through its own job as well, so it never waits on a task nobody has started.
+    while (runOneTask(*job)) {}
+
+    // whatever's left is already running on a worker
+    while (job->tasksDone.load() < numTasks) {}
+
+    job->nextTask.store(JOB_TASK_PARKED);
+    job->state.store(Job::Free);
+}
+
+
+bool MultiDlyWorkerPool::runOneTask(Job& job)
+{
+    const int task = job.nextTask.fetch_add(1);
+    if (task >= job.numTasks) return false;
+
+    {
+        MULTIDLY_REALTIME_SCOPE // tasks are part of a callback, whichever thread runs them
+        MULTIDLY_TRACE_SCOPE("worker task")
+        job.function(job.context, task);
+    }
+    job.tasksDone.fetch_add(1);
+
+    return true;
+}
+
+
+MultiDlyWorkerPool::Job* MultiDlyWorkerPool::findMostUrgentJob()
+{
+    Job* mostUrgent = nullptr;
+
+    for (auto& j : jobs)
+    {
+        if (j.state.load() != Job::Active || j.nextTask.load() >= j.numTasks) continue;
+
+        if (mostUrgent == nullptr || j.deadlineTicks < mostUrgent->deadlineTicks) mostUrgent = &j;
+    }
+
+    return mostUrgent;
+}
+
+
+//==============================================================================
+MultiDlyWorkerPool::Worker::Worker(MultiDlyWorkerPool& _pool, int index) : Thread("MultiDly worker " + String(index)), pool(_pool)
+{
+}
+
+void MultiDlyWorkerPool::Worker::run()
+{
+    int idleIterations = 0;
+
+    while (! threadShouldExit())
+    {
+        if (Job* job = pool.findMostUrgentJob())
+        {
+            // the job can be finished and reused between finding it and claiming a task from it, but a
+            // finished job's nextTask is parked out of range, so runOneTask() just returns false.
+            pool.runOneTask(*job);
+            idleIterations = 0;
+            continue;
+        }
+
+        if (++idleIterations < WORKER_SPIN_ITERATIONS) continue;
+
+        // whoever wakes this worker takes it off the count, so it doesn't decrement it itself. There's no timeout, so
+        // idle workers cost nothing until there is work.
+        ++pool.numSleepingWorkers;
+        pool.workAvailable.wait();
+
+        idleIterations = 0;
+    }
+}
+
+
+//==============================================================================
+MultiDlyWorkerPool::WakeSemaphore::WakeSemaphore()
+{
+   #if JUCE_WINDOWS
+    handle = CreateSemaphoreW(nullptr, 0, 0x7fffffff, nullptr);
+   #elif JUCE_MAC || JUCE_IOS
+    handle = (void*) dispatch_semaphore_create(0);
+   #else
+    auto* s = new sem_t;
+    sem_init(s, 0, 0);
+    handle = s;
+   #endif
+}
+
+MultiDlyWorkerPool::WakeSemaphore::~WakeSemaphore()
+{
+   #if JUCE_WINDOWS
+    CloseHandle((HANDLE) handle);
+   #elif JUCE_MAC || JUCE_IOS
+    dispatch_release((dispatch_semaphore_t) handle);
+   #else
+    sem_destroy(static_cast<sem_t*>(handle));
+    delete static_cast<sem_t*>(handle);
+   #endif
+}
+
+void MultiDlyWorkerPool::WakeSemaphore::post(int count) noexcept
+{
+    if (count <= 0) return;
+
+   #if JUCE_WINDOWS
+    ReleaseSemaphore((HANDLE) handle, count, nullptr);
+   #elif JUCE_MAC || JUCE_IOS
+    for (int i = 0; i < count; ++i) dispatch_semaphore_signal((dispatch_semaphore_t) handle);
+   #else
+    for (int i = 0; i < count; ++i) sem_post(static_cast<sem_t*>(handle));
+   #endif
+}
+
+void MultiDlyWorkerPool::WakeSemaphore::wait() noexcept
+{
+   #if JUCE_WINDOWS
+    WaitForSingleObject((HANDLE) handle, INFINITE);
+   #elif JUCE_MAC || JUCE_IOS
+    dispatch_semaphore_wait((dispatch_semaphore_t) handle, DISPATCH_TIME_FOREVER);
+   #else
+    while (sem_wait(static_cast<sem_t*>(handle)) != 0 && errno == EINTR) {}
+   #endif
+}
@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    MultiDlyWorkerPool.h
+    Created: 19 Oct 2026 9:02:11am
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#define MAX_POOL_JOBS 64
+#define JOB_TASK_PARKED (1 << 30) // the nextTask value of a free job slot, always out of range of numTasks
+#define MIN_WORK_PER_POOL_TASK 16384 // in tap-samples; below this a task costs more to hand over than to run inline
+
+#include <JuceHeader.h>
+
+
+/**
+ @brief A process-wide pool of realtime worker threads which every MultiDly instance shares.
+
+ Never construct this directly: hold a `juce::SharedResourcePointer<MultiDlyWorkerPool>` instead, so that every plugin instance in a process talks to the same pool, which is created with the first instance and destroyed with the last. The pool has a fixed number of threads, one fewer than the number of CPUs so that the host's own audio thread always has a core, no matter how many instances are loaded.
+
+ Work is submitted with run(), which is intended to be called from an audio callback. The calling thread always takes part in its own job, so it never waits on a task that no worker has started; and workers always pick the job whose deadline is closest, so a callback which is nearly out of time is served first.
+ */
+class MultiDlyWorkerPool
+{
+public:
+
+    /// The signature of a task. `context` is passed through from run() unchanged, and `taskIndex` is in the range [0, numTasks).
+    using TaskFunction = void (*)(void* context, int taskIndex);
+
+    /// Constructor. Starts the worker threads.
+    MultiDlyWorkerPool();
+
+    /// Destructor. Stops the worker threads, waiting for any running tasks to finish.
+    ~MultiDlyWorkerPool();
+
+
+    /**
+     @brief Registers an instance with the pool.
+
+     Each engine should call this once when it is created and unregisterInstance() once when it is destroyed. The number of registered instances is used by shouldParallelise().
+     */
+    void registerInstance();
+
+    /// @brief Unregisters an instance registered by registerInstance().
+    void unregisterInstance();
+
+    /// @brief Gets the number of currently registered instances.
+    int getNumRegisteredInstances() const;
+
+    /// @brief Gets the number of worker threads, not counting callers of run().
+    int getNumThreads() const;
+
+
+    /**
+     @brief Decides whether a callback with a given amount of work should use the pool at all.
+
+     Returns false if the work would be split into tasks too small to be worth handing over, or if there are already at least as many registered instances as there are cores. In the second case the host is already spreading instances across its own threads, so using the pool as well would only add scheduling overhead and the total CPU load would grow with the number of instances rather than staying flat.
+
+     @param workUnits An estimate of the work in the callback, in tap-samples (taps * channels * samples).
+     @param numTasks The number of tasks the work would be split into.
+     */
+    bool shouldParallelise(int64 workUnits, int numTasks) const;
+
+
+    /**
+     @brief Runs `numTasks` tasks, returning once all of them have completed.
+
+     The calling thread runs tasks too. If there is no free job slot, or the deadline has already passed, all of the tasks are simply run on the calling thread. This never allocates.
+
+     @param function The function to run for each task.
+     @param context Passed to each call of function.
+     @param numTasks The number of tasks to run.
+     @param deadlineTicks The time, in `juce::Time::getHighResolutionTicks()`, by which the caller needs the tasks to be done.
+     */
+    void run(TaskFunction function, void* context, int numTasks, int64 deadlineTicks);
+
+
+private:
+
+    /// A single submitted call to run(). Slots are reused, and are claimed by the submitting thread with a compare and swap.
+    struct Job
+    {
+        enum State { Free, Filling, Active };
+
+        std::atomic<int> state { Free };
+        TaskFunction function = nullptr;
+        void* context = nullptr;
+        int numTasks = 0;
+        int64 deadlineTicks = 0;
+
+        std::atomic<int> nextTask { JOB_TASK_PARKED };
+        std::atomic<int> tasksDone { 0 };
+    };
+
+    /**
+     A counting semaphore whose post() never takes a lock, so the audio thread can wake workers. Built on the OS's own
+     semaphore: POSIX on Linux, libdispatch on macOS and a kernel semaphore on Windows.
+     */
+    class WakeSemaphore
+    {
+    public:
+        WakeSemaphore();
+        ~WakeSemaphore();
+
+        /// Lets `count` waiting (or future) calls to wait() return. Lock free, and safe to call from the audio thread.
+        void post(int count) noexcept;
+
+        /// Blocks until a post() lets this call through.
+        void wait() noexcept;
+
+    private:
+        void* handle = nullptr;
+
+        JUCE_DECLARE_NON_COPYABLE (WakeSemaphore)
+    };
+
+    class Worker : public Thread
+    {
+    public:
+        Worker(MultiDlyWorkerPool& _pool, int index);
+        void run() override;
+
+    private:
+        MultiDlyWorkerPool& pool;
+    };
+
+    /// Claims and runs a single task from job, returning false if there were none left to claim.
+    static bool runOneTask(Job& job);
+
+    /// Finds the active job with the earliest deadline that still has unclaimed tasks, or nullptr if there are none.
+    Job* findMostUrgentJob();
+
+    std::array<Job, MAX_POOL_JOBS> jobs;
+    OwnedArray<Worker> workers;
+
+    WakeSemaphore workAvailable;
+    std::atomic<int> numSleepingWorkers { 0 }; // workers which are waiting, or about to wait, on workAvailable and haven't been posted to yet
+    std::atomic<int> numRegisteredInstances { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiDlyWorkerPool)
+};
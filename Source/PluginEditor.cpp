@@ -11,7 +11,7 @@
 
 //==============================================================================
 MultiDlyAudioProcessorEditor::MultiDlyAudioProcessorEditor (MultiDlyAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p), display(p), FX(p)
+    : AudioProcessorEditor (&p), audioProcessor (p), display(p), topBar(p), FX(p), tapViewer(p)
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
@@ -8,6 +8,9 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "MultiDlyRealtimeChecks.h"
+#include "MultiDlyTracer.h"
+#include "MultiDlyStateFormat.h"
 
 //==============================================================================
 MultiDlyAudioProcessor::MultiDlyAudioProcessor()
@@ -100,15 +103,29 @@ void MultiDlyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
     auto outs = getTotalNumOutputChannels();
 
     // a change in number of channels has occurred, we need to recreate the engine
-    if (EngineChannels.load() != std::max(ins, outs))
+    if (Engine == nullptr || EngineChannels.load() != std::max(ins, outs))
     {
         const int a = std::max(ins, outs);
-//        std::shared_ptr<MultiDlyEngine<PROCESSING_TYPE, a>> _engine = std::make_shared<MultiDlyEngine<PROCESSING_TYPE, a>>(sampleRate, samplesPerBlock);
 
-        // TODO: Overhaul how engine handles channels
+        // the taps outlive a change of channel count
+        if (Engine != nullptr) Engine->getState(pendingState);
 
+        // every engine registers itself with the shared worker pool, so there's nothing else to set up here.
+        const auto layout = MULTIDLY_INTERLEAVED_DELAY_BUFFER ? DelayBufferLayout::Interleaved : DelayBufferLayout::Planar;
+        Engine = createMultiDlyEngine<PROCESSING_TYPE>(a, sampleRate, samplesPerBlock, layout);
 
+        // each engine publishes to its own manager, so a new engine means a new one for the editors to poll
+        DisplayBackingClass = Engine != nullptr ? Engine->getDisplayStateManager() : nullptr;
 
+        if (Engine != nullptr && pendingState.getSize() > 0)
+        {
+            loadState(pendingState.getData(), pendingState.getSize());
+            pendingState.reset();
+        }
+    }
+    else
+    {
+        Engine->prepareToPlay(sampleRate, samplesPerBlock);
     }
     EngineChannels.store(std::max(ins, outs));
 
@@ -126,12 +143,21 @@ bool MultiDlyAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 {
 
     if (layouts.getNumChannels(true, 0) != layouts.getNumChannels(false, 0)) return false;
-    return true;
+
+    // there is only an engine for some channel counts, see createMultiDlyEngine()
+    switch (layouts.getNumChannels(false, 0))
+    {
+        case 1: case 2: case 4: case 6: case 8: case 12: case 16: case 24: return true;
+        default: return false;
+    }
 }
 #endif
 
 void MultiDlyAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    MULTIDLY_REALTIME_SCOPE
+    MULTIDLY_TIME_CALLBACK(callbackTimer, buffer.getNumSamples(), getSampleRate())
+    MULTIDLY_TRACE_SCOPE("callback")
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -147,18 +173,13 @@ void MultiDlyAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    // This is the place where you'd normally do the guts of your plugin's
-    // audio processing...
-    // Make sure to reset the state if your inner loop is processing
-    // the samples and the outer loop is handling the channels.
-    // Alternatively, you can process the samples with the channels
-    // interleaved by keeping the same state.
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        auto* channelData = buffer.getWritePointer (channel);
+    // no engine for this channel count, so pass the audio through untouched
+    if (Engine == nullptr) return;
 
-        // ..do something to the data...
-    }
+    // the host's changes since the last block take effect from its first sample
+    hostParameters.dispatchChanges(*Engine);
+
+    Engine->processBlock(buffer);
 }
 
 //==============================================================================
@@ -175,15 +196,61 @@ juce::AudioProcessorEditor* MultiDlyAudioProcessor::createEditor()
 //==============================================================================
 void MultiDlyAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // the state is a header and one fixed size record per tap, see MultiDlyStateFormat.h
+    if (Engine != nullptr) Engine->getState(destData);
+    else destData = pendingState; // the host can ask for the state it gave us before the first prepareToPlay()
 }
 
 void MultiDlyAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    if (data == nullptr || sizeInBytes <= 0) return;
+
+    // there is no engine to load into until prepareToPlay(), so keep the block until then
+    if (Engine == nullptr)
+    {
+        pendingState.replaceAll(data, (size_t) sizeInBytes);
+        hostParameters.syncFromState(data, (size_t) sizeInBytes);
+        return;
+    }
+
+    loadState(data, (size_t) sizeInBytes);
+
+    // read back from the engine rather than the block, which may have been XML
+    syncHostParameters();
+}
+
+void MultiDlyAudioProcessor::syncHostParameters()
+{
+    Engine->getState(syncScratch);
+    hostParameters.syncFromState(syncScratch.getData(), syncScratch.getSize());
+}
+
+int MultiDlyAudioProcessor::addTap(double timeMs)
+{
+    if (Engine == nullptr) return -1;
+
+    const int slot = Engine->addTapAt(timeMs);
+
+    // the new tap's slot may still hold the parameters of a tap that used to be in it
+    if (slot >= 0) syncHostParameters();
+    return slot;
+}
+
+void MultiDlyAudioProcessor::removeTap(int hostSlot)
+{
+    if (Engine == nullptr || hostSlot < 0) return;
+
+    Engine->removeTapInSlot(hostSlot);
+    syncHostParameters();
+}
+
+void MultiDlyAudioProcessor::loadState(const void* data, size_t sizeInBytes)
+{
+    if (Engine->setState(data, sizeInBytes)) return;
+
+    // not the binary format, so try the XML that copyXmlToBinary() makes of an engine's ValueTree
+    if (auto xml = getXmlFromBinary(data, (int) sizeInBytes))
+        Engine->setStateFromValueTree(ValueTree::fromXml(*xml));
 }
 
 //==============================================================================
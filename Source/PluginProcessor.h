@@ -10,9 +10,15 @@
 
 #define PROCESSING_TYPE float
 
+#ifndef MULTIDLY_INTERLEAVED_DELAY_BUFFER
+ #define MULTIDLY_INTERLEAVED_DELAY_BUFFER 0 // set by the MULTIDLY_INTERLEAVED_DELAY_BUFFER CMake option
+#endif
+
 #include <JuceHeader.h>
 #include "multiDlyEngine.h"
 #include "MultiDlyDisplayStateManager.h"
+#include "MultiDlyCallbackTimer.h"
+#include "MultiDlyHostParameters.h"
 
 
 
@@ -61,6 +67,21 @@ public:
 
     std::shared_ptr<EngineBase> getEngine() { return Engine; }
 
+    /// Gets the tap states the current engine publishes for the editors, or nullptr if there is no engine.
+    std::shared_ptr<MultiDlyDisplayStateManagerBase> getDisplayStateManager() { return DisplayBackingClass; }
+
+    /// Gets every tap slot's host parameters, which are how the editor changes taps.
+    MultiDlyHostParameters& getHostParameters() { return hostParameters; }
+
+    /// Adds a tap to the engine at a time, returning its host slot, or -1 if there is no engine or no room for another tap. Message thread only.
+    int addTap(double timeMs);
+
+    /// Removes the engine's tap with a host slot, if there is one. Message thread only.
+    void removeTap(int hostSlot);
+
+    /// Gets the record of how much of its budget each processBlock() call used. Only filled in when built with MULTIDLY_CALLBACK_TIMING.
+    const MultiDlyCallbackTimer& getCallbackTimer() const { return callbackTimer; }
+
     std::atomic<int> EngineChannels;
 private:
 
@@ -70,6 +91,19 @@ private:
     std::shared_ptr<EngineBase> Engine;
     std::shared_ptr<MultiDlyDisplayStateManagerBase> DisplayBackingClass;
 
+    MultiDlyCallbackTimer callbackTimer;
+
+    MultiDlyHostParameters hostParameters { *this }; // every tap slot's parameters, as seen by the host
+    MemoryBlock syncScratch; // the engine's state, read back to move the host parameters after a load
+
+    MemoryBlock pendingState; // state to load into the next engine, from the host before there was one or from the engine it replaces
+
+    /// Loads a block from getStateInformation() into the engine: the binary format if it is one, otherwise the XML of an engine's ValueTree.
+    void loadState(const void* data, size_t sizeInBytes);
+
+    /// Moves the host parameters to the engine's taps, after anything but the host parameters has changed them.
+    void syncHostParameters();
+
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiDlyAudioProcessor)
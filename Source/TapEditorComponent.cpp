@@ -14,13 +14,15 @@
 //==============================================================================
 TapEditorComponent::TapEditorComponent(MultiDlyAudioProcessor& p) : _p(p)
 {
-    // In your constructor, you should add any child components, and
-    // initialise any special settings that your component needs.
+    addChildComponent(lasso);
 
+    startTimerHz(TAP_EDITOR_FRAME_RATE_HZ);
 }
 
 TapEditorComponent::~TapEditorComponent()
 {
+    // the selection calls back into the taps as it empties, so it has to go before they do
+    selection.deselectAll();
 }
 
 void TapEditorComponent::paint (juce::Graphics& g)
@@ -37,75 +39,261 @@ void TapEditorComponent::paint (juce::Graphics& g)
     g.setColour (juce::Colours::grey);
     g.drawRect (getLocalBounds(), 1);   // draw an outline around the component
 
-    g.setColour (juce::Colours::white);
-    g.setFont (14.0f);
-    g.drawText ("TapEditorComponent", getLocalBounds(),
-                juce::Justification::centred, true);   // draw some placeholder text
+    if (taps.isEmpty())
+    {
+        g.setColour (juce::Colours::white);
+        g.setFont (14.0f);
+        g.drawText ("TapEditorComponent", getLocalBounds(),
+                    juce::Justification::centred, true);   // draw some placeholder text
+    }
 }
 
 void TapEditorComponent::resized()
 {
-    // This method is where you should set the bounds of any child
-    // components that your component contains..
+    // every tap moves in proportion, so they keep their order and the index only needs its extents refreshed
+    for (auto* t : taps) t->setBounds(getTapBounds(*t));
 
+    index.rebuild();
 }
 
 
-void TapEditorComponent::mouseDown(const MouseEvent& m)
+float TapEditorComponent::timeToX(double timeMs) const
 {
-    const GenericScopedLock<SpinLock> sl ((edL));
+    return (float) (timeMs / (MAX_DELAY_TIME_SECONDS * 1000.0) * getWidth());
+}
 
+double TapEditorComponent::xToTime(float x) const
+{
+    return jlimit(0.0, MAX_DELAY_TIME_SECONDS * 1000.0, x / (double) jmax(1, getWidth()) * (MAX_DELAY_TIME_SECONDS * 1000.0));
+}
 
+Rectangle<int> TapEditorComponent::getTapBounds(const DlyTapComponent& t) const
+{
+    const int x = roundToInt(timeToX(t.getTimeMs())) - DLY_TAP_COMPONENT_WIDTH / 2;
+    return { x, 0, DLY_TAP_COMPONENT_WIDTH, getHeight() };
+}
 
 
+RangedAudioParameter* TapEditorComponent::getTimeParameter(const DlyTapComponent& t) const
+{
+    return _p.getHostParameters().getParameter(t.getHostSlot(), TapParameter::TimeMs);
 }
 
-void TapEditorComponent::mouseUp(const MouseEvent& m)
+
+void TapEditorComponent::timerCallback()
 {
-    if (! m.mouseWasDraggedSinceMouseDown())
+    // a new engine comes with a new manager, whose versions start again from nothing, and taps of its own
+    auto state = _p.getDisplayStateManager();
+
+    if (state != displayState)
     {
-        for (DlyTapComponent a : taps)
+        displayState = state;
+        knownGeneration = 0;
+        tapStates.fill(TapDisplayState());
+        tapVersions.fill(0);
+        slotPublished.fill(false);
+
+        for (int i = taps.size(); --i >= 0;)
         {
-            // do hit test, change focus if necessary
+            if (taps.getUnchecked(i)->getHostSlot() >= 0) removeTap(taps.getUnchecked(i));
+        }
+    }
+
+    if (displayState == nullptr || displayState->getGeneration() == knownGeneration) return;
+    knownGeneration = displayState->getGeneration();
+
+    bool changed = false;
+    for (int i = 0; i < DISPLAY_STATE_MAX_TAPS; ++i) changed |= displayState->readTapIfChanged(i, tapStates[(size_t) i], tapVersions[(size_t) i]);
+
+    if (changed) updateLinkedTaps();
+}
+
+void TapEditorComponent::updateLinkedTaps()
+{
+    // the display state is in the engine's time order, but taps are linked by slot, which stays put as taps move
+    std::array<const TapDisplayState*, MAX_NUM_DLY_TAPS> published {};
+
+    for (const auto& s : tapStates)
+    {
+        if (s.tapId != nullptr && isPositiveAndBelow(s.hostSlot, MAX_NUM_DLY_TAPS)) published[(size_t) s.hostSlot] = &s;
+    }
+
+    for (int slot = 0; slot < MAX_NUM_DLY_TAPS; ++slot)
+    {
+        DlyTapComponent* t = linkedTaps[(size_t) slot];
 
-            if (a.contains(m.getPosition()))
+        if (const auto* s = published[(size_t) slot])
+        {
+            if (t == nullptr)
             {
-                focusedTap = &a;
+                auto added = std::make_unique<DlyTapComponent>(s->timeMs);
+                added->setHostSlot(slot);
+                addTap(std::move(added), false);
             }
+            else if (! draggedTaps.contains(t) && t->getTimeMs() != s->timeMs)
+            {
+                // a tap being dragged is ahead of the engine, which is still catching up with the drag
+                t->setTimeMs(s->timeMs);
+                index.setTapBounds(t, getTapBounds(*t));
+            }
+        }
+        else if (t != nullptr && slotPublished[(size_t) slot])
+        {
+            // only once the engine has had the tap and then dropped it: one added here is linked before its first publish
+            removeTap(t);
         }
+
+        slotPublished[(size_t) slot] = published[(size_t) slot] != nullptr;
+    }
+}
+
+
+void TapEditorComponent::mouseDown(const MouseEvent& m)
+{
+    DlyTapComponent* hit = index.findAt(m.getPosition());
+
+    if (hit == nullptr)
+    {
+        lassoing = true;
+        lasso.beginLasso(m, this);
+        return;
     }
 
+    // a click on a selected tap keeps the selection, so that the whole selection can be dragged
+    selectionResultOnMouseDown = selection.addToSelectionOnMouseDown(hit, m.mods);
+    setFocusedTap(hit);
+
+    draggedTaps.clearQuick();
+    dragStartTimes.clearQuick();
+
+    for (auto* t : selection)
+    {
+        draggedTaps.add(t);
+        dragStartTimes.add(t->getTimeMs());
+
+        // the whole drag is one edit as far as the host is concerned
+        if (auto* parameter = getTimeParameter(*t)) parameter->beginChangeGesture();
+    }
+}
+
+void TapEditorComponent::mouseUp(const MouseEvent& m)
+{
+    if (lassoing)
+    {
+        lasso.endLasso();
+        lassoing = false;
+
+        // a click on empty space, rather than a drag, clears the focus along with the selection
+        if (! m.mouseWasDraggedSinceMouseDown()) setFocusedTap(nullptr);
+        return;
+    }
+
+    // a plain click on one tap of a selection selects just that tap, which can only be told apart from the start of a
+    // drag once the mouse is released. mouseDown() focused the tap that was clicked.
+    if (focusedTap != nullptr) selection.addToSelectionOnMouseUp(focusedTap, m.mods, m.mouseWasDraggedSinceMouseDown(), selectionResultOnMouseDown);
+
+    for (auto* t : draggedTaps)
+    {
+        if (auto* parameter = getTimeParameter(*t)) parameter->endChangeGesture();
+    }
+
+    draggedTaps.clearQuick();
+    dragStartTimes.clearQuick();
 }
 
 void TapEditorComponent::mouseDrag(const MouseEvent& m)
 {
+    if (lassoing)
+    {
+        lasso.dragLasso(m);
+        return;
+    }
+
+    const double offsetMs = m.getDistanceFromDragStartX() * (MAX_DELAY_TIME_SECONDS * 1000.0) / jmax(1, getWidth());
 
+    for (int i = 0; i < draggedTaps.size(); ++i)
+    {
+        auto* t = draggedTaps.getUnchecked(i);
+        t->setTimeMs(jlimit(0.0, MAX_DELAY_TIME_SECONDS * 1000.0, dragStartTimes.getUnchecked(i) + offsetMs));
+        index.setTapBounds(t, getTapBounds(*t));
+
+        // the engine only ever hears of the change from the host parameter, never from here directly
+        if (auto* parameter = getTimeParameter(*t)) parameter->setValueNotifyingHost(parameter->convertTo0to1((float) t->getTimeMs()));
+    }
+}
+
+
+void TapEditorComponent::findLassoItemsInArea(Array<DlyTapComponent*>& itemsFound, const Rectangle<int>& area)
+{
+    index.findIn(area, itemsFound);
 }
 
 
-void TapEditorComponent::addTap(DlyTapComponent t, bool shouldGainFocus, bool shouldAlsoAddToEngine)
+DlyTapComponent* TapEditorComponent::addTap(std::unique_ptr<DlyTapComponent> t, bool shouldGainFocus, bool shouldAlsoAddToEngine)
 {
+    if (shouldAlsoAddToEngine && t->getHostSlot() < 0) t->setHostSlot(_p.addTap(t->getTimeMs()));
+
+    auto* tap = taps.add(t.release());
 
-    if (shouldAlsoAddToEngine && _p.getEngine() != nullptr)
+    if (isPositiveAndBelow(tap->getHostSlot(), MAX_NUM_DLY_TAPS))
     {
-//        _p.getEngine()
+        jassert(linkedTaps[(size_t) tap->getHostSlot()] == nullptr); // a slot only ever has one tap
+        linkedTaps[(size_t) tap->getHostSlot()] = tap;
     }
 
+    addAndMakeVisible(tap);
+    tap->setBounds(getTapBounds(*tap));
+    index.add(tap);
 
+    // the lasso stays on top of every tap
+    lasso.toFront(false);
 
     if (shouldGainFocus)
     {
-
+        selection.selectOnly(tap);
+        setFocusedTap(tap);
     }
 
+    repaint();
+    return tap;
 }
 
 void TapEditorComponent::removeTap(DlyTapComponent* pt, bool shouldAlsoRemoveFromEngine)
 {
-    
+    if (pt == nullptr || ! taps.contains(pt)) return;
+
+    // nothing may be left pointing at it once it's deleted
+    if (focusedTap == pt) setFocusedTap(nullptr);
+    selection.deselect(pt);
+
+    const int dragged = draggedTaps.indexOf(pt);
+    if (dragged >= 0)
+    {
+        if (auto* parameter = getTimeParameter(*pt)) parameter->endChangeGesture();
+
+        draggedTaps.remove(dragged);
+        dragStartTimes.remove(dragged);
+    }
+
+    const int slot = pt->getHostSlot();
+
+    if (isPositiveAndBelow(slot, MAX_NUM_DLY_TAPS))
+    {
+        if (linkedTaps[(size_t) slot] == pt) linkedTaps[(size_t) slot] = nullptr;
+        if (shouldAlsoRemoveFromEngine) _p.removeTap(slot);
+    }
+
+    index.remove(pt);
+    taps.removeObject(pt);
+
+    repaint();
 }
 
 void TapEditorComponent::setFocusedTap(DlyTapComponent* t)
 {
+    jassert(t == nullptr || taps.contains(t));
 
+    if (focusedTap != nullptr) focusedTap->setFocused(false);
+    focusedTap = t;
+    if (focusedTap != nullptr) focusedTap->setFocused(true);
 }
@@ -12,12 +12,20 @@
 
 #include <JuceHeader.h>
 #include "DlyTapComponent.h"
+#include "TapHitIndex.h"
 #include "PluginProcessor.h"
 
+#define TAP_EDITOR_FRAME_RATE_HZ 30
+
 //==============================================================================
 /*
+ Lets the user place taps along a time axis: click a tap to focus it, shift or command click to add it to the selection, drag to move the selection, and drag over empty space to select with a rubber band.
+
+ Taps are found with a TapHitIndex rather than by asking each child, so clicks, rubber bands and drags cost about the same with hundreds of taps as with a few.
+
+ Every tap in the engine gets a tap here, linked to it by its host slot, which the editor keeps up to date by polling the processor's MultiDlyDisplayStateManager. Dragging a linked tap moves its time through the host parameters, as one gesture per drag, so the host records the edit and the engine hears of it the same way as it does of automation.
 */
-class TapEditorComponent  : public juce::Component
+class TapEditorComponent  : public juce::Component, private LassoSource<DlyTapComponent*>, private juce::Timer
 {
 public:
     TapEditorComponent(MultiDlyAudioProcessor& p);
@@ -30,16 +38,75 @@ public:
     void mouseUp(const MouseEvent& m) override;
     void mouseDrag(const MouseEvent& m) override;
 
-    void addTap(DlyTapComponent t, bool shouldGainFocus, bool shouldAlsoAddToEngine=false);
+    /**
+     Takes ownership of a tap and places it at its time. Returns the tap, which stays valid until it is removed.
+
+     If shouldAlsoAddToEngine is true and the tap isn't already linked, a tap is added to the engine at the same time and the two are linked; if the engine is full the tap stays unlinked.
+     */
+    DlyTapComponent* addTap(std::unique_ptr<DlyTapComponent> t, bool shouldGainFocus, bool shouldAlsoAddToEngine=false);
+
+    /// Removes and deletes a tap, dropping it from the selection and focus first, and if shouldAlsoRemoveFromEngine is true, removing the engine tap it is linked to.
     void removeTap(DlyTapComponent* pt, bool shouldAlsoRemoveFromEngine=false);
+
+    /// Focuses a tap, or nothing if t is nullptr.
     void setFocusedTap(DlyTapComponent* t);
 
+    DlyTapComponent* getFocusedTap() const { return focusedTap; }
+
+    /// Gets the tap at a point in this component, or nullptr if there isn't one.
+    DlyTapComponent* getTapAt(Point<int> position) const { return index.findAt(position); }
+
 private:
-    std::vector<DlyTapComponent> taps;
-    DlyTapComponent* focusedTap = nullptr;
+    void timerCallback() override;
+
+    /// Adds, moves and removes linked taps to match the engine's, from tapStates.
+    void updateLinkedTaps();
+
+    // LassoSource
+    void findLassoItemsInArea(Array<DlyTapComponent*>& itemsFound, const Rectangle<int>& area) override;
+    SelectedItemSet<DlyTapComponent*>& getLassoSelection() override { return selection; }
+
+    /// The x coordinate of a time, and the other way round.
+    float timeToX(double timeMs) const;
+    double xToTime(float x) const;
+
+    /// Gets where a tap should be, from its time.
+    Rectangle<int> getTapBounds(const DlyTapComponent& t) const;
+
+    /// Gets the host parameter for a tap's time, or nullptr if it isn't linked to an engine tap.
+    RangedAudioParameter* getTimeParameter(const DlyTapComponent& t) const;
+
+    /// A selection which keeps each tap's selected flag in step with it.
+    class TapSelection : public SelectedItemSet<DlyTapComponent*>
+    {
+    public:
+        void itemSelected(DlyTapComponent* t) override { t->setSelected(true); }
+        void itemDeselected(DlyTapComponent* t) override { t->setSelected(false); }
+    };
+
+    OwnedArray<DlyTapComponent> taps;
+    TapHitIndex index; // every tap in taps, by position
+    TapSelection selection;
+    DlyTapComponent* focusedTap = nullptr; // always one of taps, or nullptr
+
+    LassoComponent<DlyTapComponent*> lasso;
+    bool lassoing = false;
+    bool selectionResultOnMouseDown = false; // from SelectedItemSet::addToSelectionOnMouseDown(), for addToSelectionOnMouseUp()
+
+    // the selection's times when the drag began, so a drag never accumulates rounding from one event to the next
+    Array<DlyTapComponent*> draggedTaps;
+    Array<double> dragStartTimes;
+
+    // the engine's taps, as last read from its display state
+    std::shared_ptr<MultiDlyDisplayStateManagerBase> displayState;
+    uint32 knownGeneration = 0;
+    std::array<TapDisplayState, DISPLAY_STATE_MAX_TAPS> tapStates;
+    std::array<uint32, DISPLAY_STATE_MAX_TAPS> tapVersions {};
+
+    std::array<DlyTapComponent*, MAX_NUM_DLY_TAPS> linkedTaps {}; // the tap linked to each host slot, always one of taps, or nullptr
+    std::array<bool, MAX_NUM_DLY_TAPS> slotPublished {}; // whether the display state had a tap in each slot when it was last read
 
     MultiDlyAudioProcessor& _p;
 
-    SpinLock edL;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TapEditorComponent)
 };
@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    TapHitIndex.cpp
+    Created: 19 Oct 2026 10:12:48pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#include "TapHitIndex.h"
+#include "DlyTapComponent.h"
+
+
+void TapHitIndex::clear()
+{
+    entries.clear();
+    maxWidth = 0;
+}
+
+
+void TapHitIndex::add(DlyTapComponent* tap)
+{
+    const auto bounds = tap->getBounds();
+    maxWidth = jmax(maxWidth, bounds.getWidth());
+
+    entries.insert(entries.begin() + (std::ptrdiff_t) lowerBound(bounds.getX()), { bounds.getX(), bounds.getRight(), tap });
+}
+
+
+void TapHitIndex::remove(DlyTapComponent* tap)
+{
+    const size_t i = indexOf(tap);
+    if (i < entries.size()) entries.erase(entries.begin() + (std::ptrdiff_t) i);
+}
+
+
+void TapHitIndex::setTapBounds(DlyTapComponent* tap, Rectangle<int> newBounds)
+{
+    size_t i = indexOf(tap);
+    tap->setBounds(newBounds);
+
+    if (i >= entries.size()) return;
+
+    maxWidth = jmax(maxWidth, newBounds.getWidth());
+    entries[i].left = newBounds.getX();
+    entries[i].right = newBounds.getRight();
+
+    // shuffle it along to where it belongs, which is only a few places for a drag
+    while (i > 0 && entries[i - 1].left > entries[i].left)
+    {
+        std::swap(entries[i - 1], entries[i]);
+        --i;
+    }
+
+    while (i + 1 < entries.size() && entries[i + 1].left < entries[i].left)
+    {
+        std::swap(entries[i + 1], entries[i]);
+        ++i;
+    }
+}
+
+
+void TapHitIndex::rebuild()
+{
+    for (auto& e : entries)
+    {
+        const auto bounds = e.tap->getBounds();
+        maxWidth = jmax(maxWidth, bounds.getWidth());
+        e.left = bounds.getX();
+        e.right = bounds.getRight();
+    }
+
+    std::sort(entries.begin(), entries.end(), [] (const Entry& a, const Entry& b) { return a.left < b.left; });
+}
+
+
+size_t TapHitIndex::lowerBound(int x) const
+{
+    return (size_t) (std::lower_bound(entries.begin(), entries.end(), x, [] (const Entry& e, int value) { return e.left < value; }) - entries.begin());
+}
+
+
+size_t TapHitIndex::indexOf(const DlyTapComponent* tap) const
+{
+    for (size_t i = lowerBound(tap->getX()); i < entries.size() && entries[i].left == tap->getX(); ++i)
+    {
+        if (entries[i].tap == tap) return i;
+    }
+
+    // either it isn't indexed, or it has been moved without going through setTapBounds()
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (entries[i].tap == tap)
+        {
+            jassertfalse;
+            return i;
+        }
+    }
+
+    return entries.size();
+}
+
+
+DlyTapComponent* TapHitIndex::findAt(Point<int> position) const
+{
+    DlyTapComponent* best = nullptr;
+    int bestDistance = std::numeric_limits<int>::max();
+
+    // no tap starting further left than this can reach the point
+    for (size_t i = lowerBound(position.x - maxWidth + 1); i < entries.size() && entries[i].left <= position.x; ++i)
+    {
+        const auto& e = entries[i];
+        if (position.x >= e.right || ! e.tap->getBounds().contains(position)) continue;
+
+        const int distance = std::abs(position.x - (e.left + e.right) / 2);
+
+        if (distance < bestDistance)
+        {
+            best = e.tap;
+            bestDistance = distance;
+        }
+    }
+
+    return best;
+}
+
+
+void TapHitIndex::findIn(Rectangle<int> area, Array<DlyTapComponent*>& results) const
+{
+    for (size_t i = lowerBound(area.getX() - maxWidth + 1); i < entries.size() && entries[i].left < area.getRight(); ++i)
+    {
+        const auto& e = entries[i];
+        if (e.right > area.getX() && e.tap->getBounds().intersects(area)) results.add(e.tap);
+    }
+}
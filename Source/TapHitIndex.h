@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    TapHitIndex.h
+    Created: 19 Oct 2026 10:12:48pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class DlyTapComponent;
+
+
+/**
+ @brief An index of the horizontal extents of a TapEditorComponent's taps, sorted by their left edge, for finding taps by position without looking at every one.
+
+ Taps are laid out by time, so this is also the taps in time order. Every interval containing a point starts no more than the widest tap's width to its left, so a hit test is a binary search followed by a scan over the few taps that can overlap the point, and a rubber band selection is a binary search followed by a scan over just the taps inside it.
+
+ Entries hold a copy of each tap's extent, so indexed taps must only be moved through setTapBounds(), or all at once followed by rebuild(). A moved tap is shuffled along to its new place, which costs as many steps as the taps it passed: dragging a tap a few pixels is a handful of steps however many taps there are.
+ */
+class TapHitIndex
+{
+public:
+
+    /// @brief Removes every tap.
+    void clear();
+
+    /// @brief Adds a tap at its current bounds.
+    void add(DlyTapComponent* tap);
+
+    /// @brief Removes a tap, if it is in the index.
+    void remove(DlyTapComponent* tap);
+
+    /// @brief Moves a tap, and moves its entry to match.
+    void setTapBounds(DlyTapComponent* tap, Rectangle<int> newBounds);
+
+    /// @brief Re-reads every tap's bounds and re-sorts, for when every tap has moved at once, such as on a resize.
+    void rebuild();
+
+    /// @brief Gets the number of taps in the index.
+    int size() const { return (int) entries.size(); }
+
+    /**
+     @brief Finds the tap at a point, or nullptr if there isn't one.
+
+     Where taps overlap, the one whose centre is closest to the point wins, as that's the one the user is most likely aiming for.
+     */
+    DlyTapComponent* findAt(Point<int> position) const;
+
+    /// @brief Adds every tap whose bounds intersect area to results, in time order.
+    void findIn(Rectangle<int> area, Array<DlyTapComponent*>& results) const;
+
+private:
+
+    struct Entry
+    {
+        int left, right;
+        DlyTapComponent* tap;
+    };
+
+    /// Gets the index of the first entry whose left edge is at least x.
+    size_t lowerBound(int x) const;
+
+    /// Gets the index of tap's entry, which is found from its current left edge, or entries.size() if it isn't in the index.
+    size_t indexOf(const DlyTapComponent* tap) const;
+
+    std::vector<Entry> entries; // sorted by left
+    int maxWidth = 0; // the widest tap ever added, so it can be larger than any current tap but never smaller
+};
@@ -12,40 +12,207 @@
 #include "TapViewer.h"
 
 //==============================================================================
-TapViewer::TapViewer()
+TapViewer::TapViewer(MultiDlyAudioProcessor& p) : _p(p)
 {
-    // In your constructor, you should add any child components, and
-    // initialise any special settings that your component needs.
+    list.setRowHeight(TAP_VIEWER_ROW_HEIGHT);
+    list.setColour(juce::ListBox::backgroundColourId, juce::Colours::transparentBlack); // our own background shows through
+    addAndMakeVisible(list);
 
+    startTimerHz(TAP_VIEWER_FRAME_RATE_HZ);
 }
 
 TapViewer::~TapViewer()
 {
+    // the list holds rows which point back at us, so it must let go of them first
+    list.setModel(nullptr);
 }
 
-void TapViewer::paint (juce::Graphics& g)
+void TapViewer::timerCallback()
+{
+    if (paintTimer.shouldSkipFrame(1000.0 / TAP_VIEWER_FRAME_RATE_HZ)) return;
+
+    // a copy of the shared_ptr, so the engine can't go away underneath us if the processor replaces it
+    auto engine = _p.getEngine();
+    if (engine == nullptr) return;
+
+    const int numTaps = levels.numTaps;
+    engine->getLatestLevels(levels);
+
+    // a new engine comes with a new manager, whose versions start again from nothing
+    auto state = _p.getDisplayStateManager();
+
+    if (state != displayState)
+    {
+        displayState = state;
+        knownGeneration = 0;
+        tapStates.fill(TapDisplayState());
+        tapVersions.fill(0);
+    }
+
+    if (displayState != nullptr && displayState->getGeneration() != knownGeneration)
+    {
+        knownGeneration = displayState->getGeneration();
+
+        // only the taps that changed are copied; the rows showing them notice the new version in update()
+        for (int i = 0; i < DISPLAY_STATE_MAX_TAPS; ++i) displayState->readTapIfChanged(i, tapStates[(size_t) i], tapVersions[(size_t) i]);
+    }
+
+    const bool newCosts = engine->getLatestTapCosts(costs);
+
+    if (levels.numTaps != numTaps)
+    {
+        list.updateContent();
+        repaint(); // for the placeholder
+    }
+
+    updateVisibleRows(newCosts);
+}
+
+void TapViewer::updateVisibleRows(bool newCosts)
+{
+    const int first = jmax(0, list.getRowContainingPosition(0, 0));
+    const int last = jmin(levels.numTaps, first + list.getNumRowsOnScreen() + 1);
+
+    for (int i = first; i < last; ++i)
+    {
+        if (auto* row = static_cast<Row*>(list.getComponentForRowNumber(i))) row->update(newCosts);
+    }
+}
+
+juce::Component* TapViewer::refreshComponentForRow(int rowNumber, bool isRowSelected, juce::Component* existingComponentToUpdate)
 {
-    /* This demo code just fills the component's background and
-       draws some placeholder text to get you started.
+    ignoreUnused(isRowSelected);
+
+    // rows are only ever made here, so an existing component is always one of ours
+    auto* row = static_cast<Row*>(existingComponentToUpdate);
+    if (row == nullptr) row = new Row(*this);
+
+    row->setRow(rowNumber);
+    return row;
+}
 
-       You should replace everything in this method with your own
-       drawing code..
-    */
+void TapViewer::paint (juce::Graphics& g)
+{
+    paintTimer.startFrame(); // ended in paintOverChildren(), so that the rows are counted too
 
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));   // clear the background
 
     g.setColour (juce::Colours::grey);
     g.drawRect (getLocalBounds(), 1);   // draw an outline around the component
 
-    g.setColour (juce::Colours::white);
-    g.setFont (14.0f);
-    g.drawText ("TapViewer", getLocalBounds(),
-                juce::Justification::centred, true);   // draw some placeholder text
+    if (levels.numTaps == 0)
+    {
+        g.setColour (juce::Colours::white);
+        g.setFont (14.0f);
+        g.drawText ("TapViewer", getLocalBounds(),
+                    juce::Justification::centred, true);   // draw some placeholder text
+    }
+}
+
+void TapViewer::paintOverChildren (juce::Graphics& g)
+{
+    ignoreUnused(g);
+    paintTimer.endFrame();
 }
 
 void TapViewer::resized()
 {
-    // This method is where you should set the bounds of any child
-    // components that your component contains..
+    list.setBounds(getLocalBounds().reduced(4));
+}
+
+
+//==============================================================================
+void TapViewer::Row::setRow(int newRow)
+{
+    if (newRow == row) return;
+
+    row = newRow;
+    drawnBarWidth = -1;
+    drawnVersion = 0;
+    repaint();
+}
+
+void TapViewer::Row::update(bool newCosts)
+{
+    if (! hasTap()) return;
+
+    // meters are only repainted once their bar has actually moved on screen
+    const bool clipping = owner.levels.taps[row].level.peak >= 1.0f;
+    if (getMeterBarWidth() != drawnBarWidth || clipping != drawnClipping) repaint(getMeterBounds());
+
+    if (row < DISPLAY_STATE_MAX_TAPS && owner.tapVersions[(size_t) row] != drawnVersion) repaint(getDetailsBounds());
+
+    if (newCosts) repaint(getCostBounds());
+}
+
+Rectangle<int> TapViewer::Row::getMeterBounds() const
+{
+    return getLocalBounds().withTrimmedLeft(TAP_VIEWER_LABEL_WIDTH).withWidth(TAP_VIEWER_METER_WIDTH).reduced(0, 4);
+}
+
+Rectangle<int> TapViewer::Row::getDetailsBounds() const
+{
+    return getLocalBounds().withTrimmedLeft(TAP_VIEWER_LABEL_WIDTH + TAP_VIEWER_METER_WIDTH + 8).withWidth(TAP_VIEWER_DETAILS_WIDTH);
+}
+
+Rectangle<int> TapViewer::Row::getCostBounds() const
+{
+    return getLocalBounds().withTrimmedLeft(TAP_VIEWER_LABEL_WIDTH + TAP_VIEWER_METER_WIDTH + 8 + TAP_VIEWER_DETAILS_WIDTH);
+}
+
+int TapViewer::Row::getMeterBarWidth() const
+{
+    // the wet level, on a -60 to +6 dB scale
+    const float proportion = jlimit(0.0f, 1.0f, jmap(Decibels::gainToDecibels(owner.levels.taps[row].level.rms, -60.0f), -60.0f, 6.0f, 0.0f, 1.0f));
+    return roundToInt(getMeterBounds().getWidth() * proportion);
+}
+
+void TapViewer::Row::paint (juce::Graphics& g)
+{
+    if (! hasTap()) return;
+
+    g.setColour (juce::Colours::white);
+    g.setFont (14.0f);
+    g.drawText ("tap " + String(row + 1), getLocalBounds().withWidth(TAP_VIEWER_LABEL_WIDTH), juce::Justification::centredLeft, true);
+
+    // what's drawn is only noted for the parts this paint actually covers, so a part left out of it is still repainted later
+    if (g.clipRegionIntersects(getMeterBounds()))
+    {
+        drawnBarWidth = getMeterBarWidth();
+        drawnClipping = owner.levels.taps[row].level.peak >= 1.0f;
+
+        g.setColour (juce::Colours::darkgrey);
+        g.fillRect (getMeterBounds());
+        g.setColour (drawnClipping ? juce::Colours::red : juce::Colours::green);
+        g.fillRect (getMeterBounds().withWidth(drawnBarWidth));
+    }
+
+    // both the levels and the tap states are in the engine's order, so row i is the engine's tap i in each
+    if (row < DISPLAY_STATE_MAX_TAPS && owner.tapStates[(size_t) row].tapId != nullptr && g.clipRegionIntersects(getDetailsBounds()))
+    {
+        const auto& state = owner.tapStates[(size_t) row];
+        drawnVersion = owner.tapVersions[(size_t) row];
+
+        g.setColour (juce::Colours::white);
+        g.drawText (String(state.timeMs, 1) + " ms  mix " + String(roundToInt(state.mix * 100.0)) + "%  fb " + String(roundToInt(state.feedback * 100.0)) + "%",
+                    getDetailsBounds(), juce::Justification::centredLeft, true);
+    }
+
+   #if MULTIDLY_TAP_PROFILING
+    // costs are matched by tap rather than by row, as the two snapshots needn't come from the same block
+    for (int c = 0; c < owner.costs.numTaps; ++c)
+    {
+        if (owner.costs.taps[c].tapId != owner.levels.taps[row].tapId) continue;
+
+        const auto& tap = owner.costs.taps[c];
+        const double samples = (double) jmax((int64) 1, tap.samples);
 
+        g.setColour (juce::Colours::white);
+        g.drawText ("read " + String(tap.cycles[TapCostSnapshot::Read] / samples, 1)
+                        + "  filt " + String(tap.cycles[TapCostSnapshot::Filter] / samples, 1)
+                        + "  ws " + String(tap.cycles[TapCostSnapshot::Waveshaper] / samples, 1)
+                        + "  comp " + String(tap.cycles[TapCostSnapshot::Compressor] / samples, 1),
+                    getCostBounds(), juce::Justification::centredLeft, true);
+    }
+   #endif
 }
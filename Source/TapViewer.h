@@ -11,19 +11,91 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "CachedLayer.h"
+
+#define TAP_VIEWER_FRAME_RATE_HZ 30
+#define TAP_VIEWER_ROW_HEIGHT 16
+#define TAP_VIEWER_LABEL_WIDTH 48
+#define TAP_VIEWER_METER_WIDTH 60
+#define TAP_VIEWER_DETAILS_WIDTH 180
 
 //==============================================================================
 /*
+ Lists the engine's taps, each with a meter of its wet level and its time, mix and feedback. When built with MULTIDLY_TAP_PROFILING, each row also shows what the tap costs per sample in each of its stages.
+
+ The list is a juce::ListBox, so there are only ever as many row components as fit on screen; as the list scrolls they are recycled and bound to other taps. Each frame only visits the visible rows, and each row only repaints its meter once the bar has moved by at least a pixel, its details once its tap's version in the processor's MultiDlyDisplayStateManager has changed, and its cost text when there are new costs.
 */
-class TapViewer  : public juce::Component
+class TapViewer  : public juce::Component, private juce::Timer, private juce::ListBoxModel
 {
 public:
-    TapViewer();
+    TapViewer(MultiDlyAudioProcessor& p);
     ~TapViewer() override;
 
     void paint (juce::Graphics&) override;
+    void paintOverChildren (juce::Graphics&) override;
     void resized() override;
 
+    /// Gets how long this component and its rows take to paint.
+    const PaintTimer& getPaintTimer() const { return paintTimer; }
+
 private:
+    void timerCallback() override;
+
+    // ListBoxModel
+    int getNumRows() override { return levels.numTaps; }
+    void paintListBoxItem (int, juce::Graphics&, int, int, bool) override {} // rows paint themselves
+    juce::Component* refreshComponentForRow (int rowNumber, bool isRowSelected, juce::Component* existingComponentToUpdate) override;
+
+    /// One row of the list, bound to whichever tap the list currently has it showing.
+    class Row : public juce::Component
+    {
+    public:
+        Row(TapViewer& _owner) : owner(_owner) {}
+
+        /// Binds the row to tap index newRow, repainting it if that's a different tap.
+        void setRow(int newRow);
+
+        /// Repaints whichever parts of the row no longer match what the owner has.
+        void update(bool newCosts);
+
+        void paint (juce::Graphics&) override;
+
+    private:
+        Rectangle<int> getMeterBounds() const;
+        Rectangle<int> getDetailsBounds() const;
+        Rectangle<int> getCostBounds() const;
+
+        /// Gets the width of the meter bar for the tap's current level, in whole pixels.
+        int getMeterBarWidth() const;
+
+        bool hasTap() const { return row >= 0 && row < owner.levels.numTaps; }
+
+        TapViewer& owner;
+        int row = -1;
+
+        // what was last painted, to tell which parts have changed
+        int drawnBarWidth = -1;
+        bool drawnClipping = false;
+        uint32 drawnVersion = 0;
+    };
+
+    /// Calls update() on every row that's on screen.
+    void updateVisibleRows(bool newCosts);
+
+    MultiDlyAudioProcessor& _p;
+    TapCostSnapshot costs; // the last snapshot taken from the engine
+    LevelSnapshot levels; // likewise
+
+    // the tap states as last read, and the versions they were read at
+    std::shared_ptr<MultiDlyDisplayStateManagerBase> displayState;
+    uint32 knownGeneration = 0;
+    std::array<TapDisplayState, DISPLAY_STATE_MAX_TAPS> tapStates;
+    std::array<uint32, DISPLAY_STATE_MAX_TAPS> tapVersions {};
+
+    juce::ListBox list { "taps", this };
+
+    PaintTimer paintTimer;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TapViewer)
 };
@@ -12,17 +12,32 @@
 #include "TopBarComponent.h"
 
 //==============================================================================
-TopBarComponent::TopBarComponent()
+TopBarComponent::TopBarComponent(MultiDlyAudioProcessor& p) : _p(p)
 {
-    // In your constructor, you should add any child components, and
-    // initialise any special settings that your component needs.
-
+    startTimer(TOP_BAR_STATS_INTERVAL_MS);
 }
 
 TopBarComponent::~TopBarComponent()
 {
 }
 
+void TopBarComponent::timerCallback()
+{
+   #if MULTIDLY_CALLBACK_TIMING
+    stats = _p.getCallbackTimer().getStats();
+    repaint();
+   #endif
+
+    auto engine = _p.getEngine();
+    const uint32 failures = engine != nullptr ? engine->getNumStageAcquireFailures() : 0;
+
+    if (failures != stageAcquireFailures)
+    {
+        stageAcquireFailures = failures;
+        repaint();
+    }
+}
+
 void TopBarComponent::paint (juce::Graphics& g)
 {
     /* This demo code just fills the component's background and
@@ -39,8 +54,26 @@ void TopBarComponent::paint (juce::Graphics& g)
 
     g.setColour (juce::Colours::white);
     g.setFont (14.0f);
+
+    if (stageAcquireFailures > 0)
+    {
+        g.setColour (juce::Colours::red);
+        g.drawText ("taps ran without their filters or compressor " + String(stageAcquireFailures) + " times",
+                    getLocalBounds().reduced(8, 0), juce::Justification::centredLeft, true);
+        g.setColour (juce::Colours::white);
+    }
+
+   #if MULTIDLY_CALLBACK_TIMING
+    // the red means at least one callback has run past its deadline, which the host will have heard as a dropout
+    if (stats.numDeadlineMisses > 0) g.setColour (juce::Colours::red);
+
+    g.drawText ("load " + String(stats.meanLoad * 100.0, 1) + "%  p99 " + String(stats.p99Load * 100.0, 0)
+                    + "%  worst " + String(stats.worstLoad * 100.0, 0) + "%  misses " + String(stats.numDeadlineMisses),
+                getLocalBounds().reduced(8, 0), juce::Justification::centredRight, true);
+   #else
     g.drawText ("TopBarComponent", getLocalBounds(),
                 juce::Justification::centred, true);   // draw some placeholder text
+   #endif
 }
 
 void TopBarComponent::resized()
@@ -11,19 +11,29 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#define TOP_BAR_STATS_INTERVAL_MS 500
 
 //==============================================================================
 /*
+ The bar along the top of the editor. When built with MULTIDLY_CALLBACK_TIMING it shows how much of its realtime budget the processor is using. It always warns when taps have had to run without their filter or compressor stages.
 */
-class TopBarComponent  : public juce::Component
+class TopBarComponent  : public juce::Component, private juce::Timer
 {
 public:
-    TopBarComponent();
+    TopBarComponent(MultiDlyAudioProcessor& p);
     ~TopBarComponent() override;
 
     void paint (juce::Graphics&) override;
     void resized() override;
 
 private:
+    void timerCallback() override;
+
+    MultiDlyAudioProcessor& _p;
+    MultiDlyCallbackTimer::Stats stats; // the last stats read, so paint() never reads the atomics itself
+    uint32 stageAcquireFailures = 0; // the engine's last count, see EngineBase::getNumStageAcquireFailures()
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TopBarComponent)
 };
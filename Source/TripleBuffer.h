@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+    Created: 19 Oct 2026 6:02:40pm
+    Author:  Zachary Lewis-Towbes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+/**
+ @brief Hands a value from one writer thread to one reader thread without either ever waiting for the other.
+
+ There are three copies of the value: one the writer is filling, one the reader is looking at, and a spare in between. publish() swaps the writer's copy with the spare, and update() swaps the spare with the reader's copy if the writer has published since, so each side only ever touches its own copy. The reader always sees the newest complete value, and values published in between are simply skipped.
+
+ Neither side allocates or locks, so the writer can be an audio thread. T must be default constructible and copyable.
+
+ @tparam T The value to hand over.
+ */
+template <class T>
+class TripleBuffer
+{
+public:
+
+    TripleBuffer() = default;
+
+    /// @brief Gets the copy the writer should fill. Only the writer may call this.
+    T& getWriteBuffer() noexcept { return buffers[writeIndex]; }
+
+    /// @brief Makes the write buffer the newest value, and gives the writer the spare to fill next. Only the writer may call this.
+    void publish() noexcept
+    {
+        const int previous = spare.exchange(writeIndex | freshBit, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    /// @brief Takes the newest published value, if there is one the reader hasn't seen, and returns whether it did. Only the reader may call this.
+    bool update() noexcept
+    {
+        if ((spare.load(std::memory_order_relaxed) & freshBit) == 0) return false;
+
+        const int previous = spare.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return true;
+    }
+
+    /// @brief Gets the value the reader last took with update(). Only the reader may call this.
+    const T& getReadBuffer() const noexcept { return buffers[readIndex]; }
+
+private:
+
+    static constexpr int indexMask = 3;
+    static constexpr int freshBit = 4; // set in spare when it holds a value the reader hasn't taken yet
+
+    std::array<T, 3> buffers {};
+    int writeIndex = 0, readIndex = 1; // each only touched by its own side
+    std::atomic<int> spare { 2 };
+
+    JUCE_DECLARE_NON_COPYABLE (TripleBuffer)
+};
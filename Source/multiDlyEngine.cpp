@@ -10,187 +10,1611 @@
 
 
 #include "multiDlyEngine.h"
+#include "MultiDlyRealtimeChecks.h"
 
 template<class T, int Ch>
-MultiDlyEngine<T, Ch>::MultiDlyEngine(double sampleRate, int blockSize) : numChannels(Ch)
+MultiDlyEngine<T, Ch>::MultiDlyEngine(double sampleRate, int blockSize, DelayBufferLayout layout, DelayBufferFormat format) : numChannels(Ch), data(layout, format, DELAY_BUFFER_LENGTH)
 {
     assert(MAX_DELAY_TIME_SECONDS * 48000 <= pow(2.0f, sizeof(unsigned int) * 8)); // we need to make sure the indexes of the delay buffer are within int range
 
-    data.setSize(Ch, DELAY_BUFFER_LENGTH);
+    workerPool->registerInstance();
 
+    displayState = std::make_shared<MultiDlyDisplayStateManager<T, Ch>>();
 
+    for (auto& s : freeTapSlots) s.store(0xffffffffu);
+
+    prepareToPlay(sampleRate, blockSize);
+
+    // taps prepare themselves at the engine's sample rate, so the pool is filled once that is known
+    for (int slot = 0; slot < TAP_POOL_SIZE; ++slot)
+    {
+        tapPool[slot] = std::make_shared<MultiDlyTap<T, Ch>>(*this, DELAY_BUFFER_LENGTH);
+        tapPool[slot]->poolSlot = slot;
+    }
+
+    backgroundThread->addTimeSliceClient(this);
+}
+
+template<class T, int Ch>
+MultiDlyEngine<T, Ch>::~MultiDlyEngine()
+{
+    // waits for the background thread if it is in the middle of building an impulse response for us
+    backgroundThread->removeTimeSliceClient(this);
+
+    workerPool->unregisterInstance();
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::prepareToPlay(double sr, int block_size)
+{
+    const double oldRate = this->sr;
+
+    setBlockSize(block_size);
+    setSampleRate(sr);
+
+    if constexpr (std::is_same<T, float>::value)
+    {
+        if (staticConvolvers.isEmpty())
+        {
+            for (int chan = 0; chan < Ch; ++chan) staticConvolvers.add(new dsp::Convolution(dsp::Convolution::NonUniform { CONVOLUTION_HEAD_SIZE }, *convolutionQueue));
+        }
+
+        for (auto* c : staticConvolvers) c->prepare({ sr, (uint32) blocksize, 1 });
+
+        // tap offsets are in samples, so any impulse response built for the old rate is wrong now
+        staticTapSignature = 0;
+        convolutionWarmup = -1;
+        convolutionFade = 0;
+        loadedResponse.store(0);
+    }
+
+    if (oldRate > 0.0 && sr != oldRate && totalSamplesWritten.load() > 0) startHistoryResample(oldRate);
+
+    // the first few blocks' memory is committed here, so the first callback never faults; the background thread does the rest.
+    data.prefault((int) writeidx, 4 * blocksize);
+    data.setPrefaultTarget((int) jmin((int64) DELAY_BUFFER_LENGTH, totalSamplesWritten + PREFAULT_AHEAD_SAMPLES));
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::processBlock(AudioBuffer<float>& samples)
+{
+    // the whole block has to be done within the block's own duration
+    const double budgetSeconds = samples.getNumSamples() / sr;
+    callbackDeadlineTicks = Time::getHighResolutionTicks() + Time::secondsToHighResolutionTicks(budgetSeconds);
+
+    if constexpr (std::is_same<T, float>::value)
+    {
+        processSamples(samples);
+    }
+    else
+    {
+        jassertfalse; // only float engines are created by the processor at the moment
+    }
+}
+
+
+template<class T, int Ch>
+bool MultiDlyEngine<T, Ch>::shouldUseWorkerPool(int numTasks) const
+{
+    const int64 workUnits = (int64) num_taps * Ch * blocksize;
+
+    return workerPool->shouldParallelise(workUnits, numTasks);
+}
+
+template<class T, int Ch>
+int MultiDlyEngine<T, Ch>::getNumChannelGroups() const
+{
+    // one group for each worker plus the calling thread, but never fewer than one channel per group
+    return jmin(Ch, workerPool->getNumThreads() + 1);
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::processSamples(AudioBuffer<T>& samples)
+{
+    jassert(samples.getNumChannels() == Ch);
+
+    const int numSamples = samples.getNumSamples();
+    int nextEvent = 0;
+
+    {
+        MULTIDLY_TRACE_SCOPE("parameter table drain")
+
+        parameterTable.takeChanges([this] (int index, float value)
+        {
+            applyParameterEvent({ 0, index / numTapParameters, (TapParameter) (index % numTapParameters), value });
+        });
+    }
+
+    // Scratch buffers are only blocksize long, so larger blocks from the host are handled in chunks. Chunks also end at
+    // each parameter event, so that everything about a tap is constant within a chunk and a change lands on its sample.
+    for (int start = 0; start < numSamples;)
+    {
+        while (nextEvent < numPendingEvents && pendingEvents[nextEvent].sampleOffset <= start) applyParameterEvent(pendingEvents[nextEvent++]);
+
+        int end = jmin(numSamples, start + blocksize);
+        if (nextEvent < numPendingEvents) end = jmin(end, pendingEvents[nextEvent].sampleOffset);
+
+        processChunk(samples, start, end - start);
+        start = end;
+    }
+
+    // anything left was timed past the end of the block
+    while (nextEvent < numPendingEvents) applyParameterEvent(pendingEvents[nextEvent++]);
+    numPendingEvents = 0;
+
+    publishLevels();
+
+    // the editors poll at a frame rate, so once per block is far more often than they can need
+    displayState->publish(taps);
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::queueParameterEvent(const TapParameterEvent& event)
+{
+    if (numPendingEvents == MAX_PARAMETER_EVENTS_PER_BLOCK)
+    {
+        applyParameterEvent(event);
+        return;
+    }
+
+    // events nearly always arrive in order, so this rarely moves anything. Equal offsets keep their order, so the last
+    // change to a parameter at a sample is the one that sticks.
+    int i = numPendingEvents++;
+    for (; i > 0 && pendingEvents[i - 1].sampleOffset > event.sampleOffset; --i) pendingEvents[i] = pendingEvents[i - 1];
+
+    pendingEvents[i] = event;
+}
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::setTapParameter(int tap, TapParameter parameter, float value)
+{
+    if (! isPositiveAndBelow(tap, MAX_NUM_DLY_TAPS)) return;
+
+    parameterTable.set(tap * numTapParameters + (int) parameter, value);
+}
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::applyParameterEvent(const TapParameterEvent& event) noexcept
+{
+    // by slot rather than by index, so a change of time which re-sorts the taps doesn't move anything's automation
+    if (! isPositiveAndBelow(event.tap, MAX_NUM_DLY_TAPS) || tapsBySlot[event.tap] == nullptr) return;
+
+    tapsBySlot[event.tap]->setParameter(event.parameter, event.value);
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::processChunk(AudioBuffer<T>& samples, int startSample, int numSamples)
+{
+    profilingThisChunk = MULTIDLY_TAP_PROFILING && (++chunkCounter % TAP_PROFILE_INTERVAL_CHUNKS) == 0;
+
+    for (int chan = 0; chan < Ch; ++chan)
+    {
+        accumulateLevel(samples.getReadPointer(chan, startSample), numSamples, inputPeaks[chan], inputSumsOfSquares[chan]);
+        FloatVectorOperations::clear(wetBus + (size_t) chan * wetBusStride, numSamples);
+    }
+
+    // the input is written by the first tap set to run, together with its feedback. The write index is incremented below.
+    inputWritten = false;
+    writtenHistory = (int) jmin((int64) DELAY_BUFFER_LENGTH, totalSamplesWritten.load(std::memory_order_relaxed));
+
+    currentSamples = &samples;
+    currentStartSample = startSample;
+    currentNumSamples = numSamples;
+
+    beginCrossfade();
+
+    // Every tap's mix balances it against the same dry signal, so the dry signal is kept once, at the taps' average share
+    // of it, rather than once for each tap. Both sets' outputs have the dry signal in common, so its share crossfades
+    // linearly, whereas the wet outputs crossfade at equal power.
+    const T dryShare = getDryShare(taps);
+    T fadingDryShare = dryShare;
+    const int chunkFadePosition = fadePosition;
+
+    if (fadePosition < fadeLength)
+    {
+        fadingDryShare = getDryShare(fadingTaps);
+
+        // equal-power, so the level holds steady through the fade when the two sets' outputs are uncorrelated
+        T* fadeOut = fadeGains.get();
+        T* fadeIn = fadeGains.get() + blocksize;
+
+        for (int samp = 0; samp < numSamples; ++samp)
+        {
+            const double angle = MathConstants<double>::halfPi * jmin(1.0, (double) (fadePosition + samp) / fadeLength);
+            fadeOut[samp] = (T) std::cos(angle);
+            fadeIn[samp] = (T) std::sin(angle);
+        }
+
+        // the outgoing set runs first, so that the active set's offsets are the ones left for updateHistory()
+        processTapSet(fadingTaps, fadeOut);
+        processTapSet(taps, fadeIn);
+
+        fadePosition += numSamples;
+        if (fadePosition >= fadeLength) retireFadingTaps(); // nothing else can claim these taps' slots until then
+    }
+    else
+    {
+        processTapSet(taps, nullptr);
+    }
+
+    // the one pass over the output, which until now has been left as the dry input for the taps to read
+    for (int chan = 0; chan < Ch; ++chan)
+    {
+        T* out = samples.getWritePointer(chan, startSample);
+
+        if (fadingDryShare != dryShare)
+        {
+            for (int samp = 0; samp < numSamples; ++samp)
+                out[samp] *= fadingDryShare + (dryShare - fadingDryShare) * (T) jmin(1.0, (double) (chunkFadePosition + samp) / fadeLength);
+        }
+        else if (dryShare != (T) 1)
+        {
+            FloatVectorOperations::multiply(out, dryShare, numSamples);
+        }
+
+        FloatVectorOperations::add(out, wetBus + (size_t) chan * wetBusStride, numSamples);
+    }
+
+    for (int chan = 0; chan < Ch; ++chan) accumulateLevel(samples.getReadPointer(chan, startSample), numSamples, outputPeaks[chan], outputSumsOfSquares[chan]);
+    meteredSamples += numSamples;
+
+    if (profilingThisChunk) publishTapCosts(numSamples);
+
+    updateHistory(numSamples);
+
+    writeidx = (writeidx + numSamples) % DELAY_BUFFER_LENGTH; // add through write index.
+    totalSamplesWritten.store(totalSamplesWritten.load(std::memory_order_relaxed) + numSamples, std::memory_order_release);
+
+    data.setPrefaultTarget((int) jmin((int64) DELAY_BUFFER_LENGTH, totalSamplesWritten + PREFAULT_AHEAD_SAMPLES));
+}
+
+
+template<class T, int Ch>
+T MultiDlyEngine<T, Ch>::getDryShare(const TapSet& set) const noexcept
+{
+    double share = 0.0;
+    int numTapsInSet = 0;
+
+    for (const auto& a : set)
+    {
+        if (a == nullptr) continue;
+        share += 1.0 - a->getMix();
+        ++numTapsInSet;
+    }
+
+    return numTapsInSet > 0 ? (T) (share / numTapsInSet) : (T) 1;
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::processTapSet(TapSet& set, const T* gains)
+{
+    runningTaps = &set;
+    runningGains = gains;
+
+    // taps pick up and hand back their filter and compressor stages here, so they can't change within a chunk.
+    {
+        MULTIDLY_TRACE_SCOPE("stage sync")
+
+        for (const auto& a : set)
+        {
+            if (a != nullptr) a->syncStages(stageArena);
+        }
+    }
+
+    // Taps are classed as static or not once per chunk. A tap which starts ramping or has an FX stage enabled simply
+    // drops back to the per-sample path at the next chunk. Nothing is static while it is being faded, as the static
+    // path has no per-sample gain.
+    numStaticTaps = 0;
+    numDynamicTaps = 0;
+    for (int t = 0; t < MAX_NUM_DLY_TAPS; ++t)
+    {
+        tapIsStatic[t] = (gains == nullptr && set[t] != nullptr && set[t]->isStatic());
+        if (tapIsStatic[t]) staticTapIndices[numStaticTaps++] = t;
+        else if (set[t] != nullptr) ++numDynamicTaps;
+    }
+
+    computeTapOffsets(currentNumSamples);
+
+    updateStaticTapConvolution();
+
+    // Without cross-channel feedback, every channel only ever reads and writes its own channel of the delay buffer and
+    // its own channels of each tap's processors, so adjacent runs of channels can be processed at the same time. In the
+    // interleaved layout neighbouring channels share cache lines, so groups would just fight over them.
+    const int numGroups = getNumChannelGroups();
+
+    if (! crossChannelFeedback && data.getLayout() == DelayBufferLayout::Planar && shouldUseWorkerPool(numGroups))
+    {
+        MULTIDLY_TRACE_SCOPE("tap groups")
+        currentGroupSize = (Ch + numGroups - 1) / numGroups;
+        workerPool->run(&MultiDlyEngine<T, Ch>::processChannelGroupTask, this, (Ch + currentGroupSize - 1) / currentGroupSize, callbackDeadlineTicks);
+    }
+    else
+    {
+        MULTIDLY_TRACE_SCOPE("tap groups")
+        processChannelGroup(0, Ch);
+    }
+
+    inputWritten = true; // any set after this one only adds its feedback
+
+    // does denormal things
+    for (const auto& a : set)
+    {
+        if (a == nullptr || a->filters == nullptr) continue;
+        a->filters->lp.snapToZero();
+        a->filters->hp.snapToZero();
+    }
+
+    runningTaps = &taps;
+    runningGains = nullptr;
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::beginCrossfade() noexcept
+{
+    if (fadePosition < fadeLength || standbyState.load() != StandbyReady) return;
+
+    int expected = StandbyReady;
+    if (! standbyState.compare_exchange_strong(expected, StandbySwapping)) return; // the message thread has taken it back to rebuild
+
+    MULTIDLY_TRACE_SCOPE("standby swap")
+
+    // moving shared_ptrs about never touches their counts, so none of this can free anything
+    if (! standbyFades)
+    {
+        // An edit of the active set, whose taps carry on as they were, so it is switched to without a fade. The set it
+        // replaces is left in standbyTaps, so the message thread can hand back the taps the edit removed once they
+        // are out of the audio thread's hands.
+        std::swap(taps, standbyTaps);
+        std::swap(num_taps, standbyNumTaps);
+        crossChannelFeedback = standbyCrossChannelFeedback;
+
+        standbyState.store(StandbyEmpty);
+
+        mapTapSlots();
+        return;
+    }
+
+    std::swap(fadingTaps, taps);
+    std::swap(taps, standbyTaps);
+    num_taps = standbyNumTaps;
+    standbyNumTaps = 0;
+    crossChannelFeedback = standbyCrossChannelFeedback;
+
+    standbyState.store(StandbyEmpty);
+
+    mapTapSlots();
+
+    fadeLength = roundToInt(crossfadeTimeMs.load() * 0.001 * sr);
+    fadePosition = 0;
+
+    if (fadeLength == 0) retireFadingTaps();
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::computeTapOffsets(int numSamples)
+{
+    const TapSet& set = *runningTaps;
+
+    for (int t = 0; t < MAX_NUM_DLY_TAPS; ++t)
+    {
+        if (set[t] == nullptr) continue;
+
+        int* offsets = tapOffsets.get() + t * blocksize;
+
+        if (tapIsStatic[t])
+        {
+            offsets[0] = jlimit(0, DELAY_BUFFER_LENGTH - 1, set[t]->getWriteIndexOffset());
+            continue;
+        }
+
+        for (int samp = 0; samp < numSamples; ++samp)
+        {
+            // gets the tap time in samples, incrementing the smoothing on the smoothvalue
+            offsets[samp] = jlimit(0, DELAY_BUFFER_LENGTH - 1, set[t]->getWriteIndexOffset());
+        }
+    }
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::processChannelGroupTask(void* engine, int groupIndex)
+{
+    auto& e = *static_cast<MultiDlyEngine<T, Ch>*>(engine);
+
+    const int firstChan = groupIndex * e.currentGroupSize;
+    e.processChannelGroup(firstChan, jmin(Ch, firstChan + e.currentGroupSize));
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::processChannelGroup(int firstChan, int lastChan)
+{
+    const TapSet& set = *runningTaps;
+    const bool isActiveSet = (runningTaps == &taps); // the outgoing set of a crossfade isn't metered or profiled
+    TapStageTimer timer(profilingThisChunk && isActiveSet);
+    const bool writeInput = ! inputWritten;
+
+    // the block isn't written to until every tap set has run, so it is still the dry input
+    std::array<const T*, Ch> in {};
+    std::array<T*, Ch> wet {}, written {};
+
+    for (int chan = firstChan; chan < lastChan; ++chan)
+    {
+        in[chan] = currentSamples->getReadPointer(chan, currentStartSample);
+        wet[chan] = wetBus + (size_t) chan * wetBusStride;
+        written[chan] = chunkHistory + (size_t) chan * wetBusStride;
+    }
+
+    // with nothing reading the buffer sample by sample, the input goes in as one block copy and there's no per-sample pass
+    const int perSampleLength = numDynamicTaps > 0 ? currentNumSamples : 0;
+
+    if (perSampleLength == 0 && writeInput)
+    {
+        writeIncomingAudio(*currentSamples, currentStartSample, currentNumSamples, firstChan, lastChan);
+
+        // a later tap set in this chunk reads what was written from here
+        for (int chan = firstChan; chan < lastChan; ++chan) FloatVectorOperations::copy(written[chan], in[chan], currentNumSamples);
+    }
+
+    // In the compact formats, a per-sample tap whose time isn't moving and which only reaches history from before this
+    // chunk has its whole window converted in one block, rather than one sample at a time in the loop below.
+    std::array<bool, MAX_NUM_DLY_TAPS> tapHasWindow {};
+
+    for (int t = 0; t < MAX_NUM_DLY_TAPS && perSampleLength > 0 && tapWindows != nullptr; ++t)
+    {
+        if (set[t] == nullptr || tapIsStatic[t]) continue;
+
+        const int offset = tapOffsets[t * blocksize];
+        if (offset < perSampleLength || tapOffsets[t * blocksize + perSampleLength - 1] != offset) continue;
+
+        for (int chan = firstChan; chan < lastChan; ++chan) readHistoryWindow(chan, offset, tapWindows + (size_t) (t * Ch + chan) * blocksize, perSampleLength);
+
+        tapHasWindow[t] = true;
+    }
+
+    for (int samp = 0; samp < perSampleLength; ++samp)
+    {
+        const int w = (int) ((writeidx + samp) % DELAY_BUFFER_LENGTH);
+        const T gain = runningGains != nullptr ? runningGains[samp] : (T) 1;
+
+        // feedback from every tap is summed here and written once per channel, so the compact storage formats round
+        // (and dither) once per sample rather than once per tap. The output is summed the same way.
+        std::array<T, Ch> fdbkSum {};
+        std::array<T, Ch> wetSum {};
+
+        // taps are the outer loop so that each tap reads one frame per sample, which in the interleaved layout is a
+        // single contiguous read of all of its channels.
+        for (int t = 0; t < MAX_NUM_DLY_TAPS; ++t)
+        {
+            MultiDlyTap<T, Ch>* a = set[t].get();
+            if (a == nullptr || tapIsStatic[t]) continue; // weed out nullptr taps if applicable, and static ones which are done in one go afterwards
+
+            const int offset = tapOffsets[t * blocksize + samp];
+            int readidx = w - offset; // gets the read index
+            if (readidx < 0) readidx = DELAY_BUFFER_LENGTH + readidx; // wraps the read index if necessary
+
+            // called here because the filter could be switched to output by another thread during processing, however unlikely.
+            // A stage is only held while it's enabled, so holding one is what enables it for this chunk.
+            auto* const filters = a->filters;
+            auto* const comp = a->comp;
+            const bool filtin = (filters != nullptr);
+            const bool filtpre = a->getFiltPre();
+
+            // The whole frame is read at once, which in the interleaved layout is one contiguous load. History from this
+            // chunk isn't in the buffer until the end of the pass, so it is read from chunkHistory, and a tap with no delay
+            // reads this sample's input, unless an earlier tap set has already written it.
+            timer.start();
+            std::array<T, Ch> frame;
+
+            if (offset <= samp)
+            {
+                for (int chan = firstChan; chan < lastChan; ++chan) frame[chan] = (offset == 0 && writeInput) ? in[chan][samp] : written[chan][samp - offset];
+            }
+            else if (tapHasWindow[t])
+            {
+                const T* window = tapWindows + (size_t) t * Ch * blocksize + samp;
+                for (int chan = firstChan; chan < lastChan; ++chan) frame[chan] = window[chan * blocksize];
+            }
+            else if (offset - samp > writtenHistory)
+            {
+                // from before anything was written, so silence, and the memory may not even be committed yet
+                for (int chan = firstChan; chan < lastChan; ++chan) frame[chan] = 0;
+            }
+            else
+            {
+                data.readFrame(readidx, firstChan, lastChan, frame.data());
+            }
+
+            timer.lap(t, TapCostSnapshot::Read);
+
+            for (int chan = firstChan; chan < lastChan; ++chan)
+            {
+                timer.start();
+
+                const int fdbkChan = crossChannelFeedback ? (chan + 1) % Ch : chan;
+
+                T outval = frame[chan];
+
+                // FILTER //
+                if (filtin && filtpre)
+                {
+                    outval = filters->lp.processSample(chan, outval);
+                    outval = filters->hp.processSample(chan, outval);
+                    timer.lap(t, TapCostSnapshot::Filter);
+                }
+
+                T fdbkval = outval;
+
+                // WAVESHAPING //
+                if (a->getWSIn())
+                {
+                    outval = a->waveshaper.processSample(outval * a->getWSPreGain()) * a->getWSPostGain(); // runs the waveshaper on the outval
+
+                    // conditionally run the feedback value through the waveshaper
+                    if (a->getWSFdbk()) { fdbkval = a->waveshaper.processSample(fdbkval * a->getWSPreGain()) * a->getWSPostGain(); }
+
+                    timer.lap(t, TapCostSnapshot::Waveshaper);
+                }
+
+                // COMPRESSION //
+                if (comp != nullptr)
+                {
+                    // process feedback data on channel chan + Ch so that it doesn't interfere.
+                    if (a->getCompFdbk()) { fdbkval = comp->processSample(chan + Ch, fdbkval); }
+
+                    outval = comp->processSample(chan, outval); // runs the compressor on the outval
+                    timer.lap(t, TapCostSnapshot::Compressor);
+                }
+
+                // FILTER (if filter is in post)
+                if (filtin && ! filtpre)
+                {
+                    outval = filters->lp.processSample(chan, outval);
+                    outval = filters->hp.processSample(chan, outval);
+                    fdbkval = filters->lp.processSample(chan + Ch, fdbkval);
+                    fdbkval = filters->hp.processSample(chan + Ch, fdbkval);
+                    timer.lap(t, TapCostSnapshot::Filter);
+                }
+
+
+                fdbkSum[fdbkChan] += fdbkval * a->getFeedback() * gain;
+
+                const T wetval = outval * (T) a->getMix();
+                wetSum[chan] += wetval * gain; // the dry signal is added once for all the taps, in processChunk()
+
+                if (isActiveSet) tapWet[(size_t) (t * Ch + chan) * wetBusStride + samp] = wetval;
+
+                timer.lap(t, TapCostSnapshot::Read);
+            }
+        }
+
+        // adds the input and feedback to this chunk's history. Cross-channel feedback is only ever processed as one
+        // group, so fdbkSum only has values for this group's channels.
+        for (int chan = firstChan; chan < lastChan; ++chan)
+        {
+            wet[chan][samp] += wetSum[chan];
+            written[chan][samp] = (writeInput ? in[chan][samp] : written[chan][samp]) + fdbkSum[chan];
+        }
+    }
+
+    // each tap's level is measured over its whole wet output for the chunk in one vectorised pass, rather than sample by sample
+    if (isActiveSet)
+    {
+        for (int t = 0; t < MAX_NUM_DLY_TAPS && perSampleLength > 0; ++t)
+        {
+            if (set[t] == nullptr || tapIsStatic[t]) continue;
+
+            for (int chan = firstChan; chan < lastChan; ++chan)
+                accumulateLevel(tapWet + (size_t) (t * Ch + chan) * wetBusStride, perSampleLength, tapLevels[chan].peaks[t], tapLevels[chan].sumsOfSquares[t]);
+        }
+    }
+
+    // The chunk's history goes into the buffer as one block, so the compact formats convert it with their vectorised
+    // paths, and round it once even when a second tap set has added to it.
+    if (perSampleLength > 0)
+    {
+        const int first = jmin(perSampleLength, DELAY_BUFFER_LENGTH - (int) writeidx);
+
+        for (int chan = firstChan; chan < lastChan; ++chan)
+        {
+            data.copyFrom(chan, (int) writeidx, written[chan], first);
+            if (first < perSampleLength) data.copyFrom(chan, 0, written[chan] + first, perSampleLength - first);
+        }
+    }
+
+    processStaticTaps(firstChan, lastChan, timer);
+
+    if (timer.isActive()) mergeTapCosts(timer);
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::readHistoryWindow(int chan, int offset, T* dest, int numSamples) noexcept
+{
+    const int unwritten = jlimit(0, numSamples, offset - writtenHistory);
+    FloatVectorOperations::clear(dest, unwritten);
+
+    const int num = numSamples - unwritten;
+    if (num == 0) return;
+
+    int readidx = (int) writeidx - offset + unwritten;
+    if (readidx < 0) readidx += DELAY_BUFFER_LENGTH;
+
+    const int first = jmin(num, DELAY_BUFFER_LENGTH - readidx);
+    data.copyTo(chan, readidx, dest + unwritten, first);
+    if (first < num) data.copyTo(chan, 0, dest + unwritten + first, num - first);
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::processStaticTaps(int firstChan, int lastChan, TapStageTimer& timer)
+{
+    if (numStaticTaps == 0) return;
+
+    const int numSamples = currentNumSamples;
+
+    for (int chan = firstChan; chan < lastChan; ++chan)
+    {
+        T* out = wetBus + (size_t) chan * wetBusStride;
+        T* window = staticTapWindow.get() + chan * blocksize;
+        T* convolved = nullptr;
+        T* firOut = out; // where the sparse FIR adds its output: out, or its own window while it's crossfaded with the convolvers
+
+        timer.start();
+
+        if constexpr (std::is_same<T, float>::value)
+        {
+            if (feedConvolvers)
+            {
+                convolved = convolutionWindows.get() + (size_t) chan * 2 * blocksize;
+
+                // the history written this chunk, input plus feedback, is what the static taps are reading a delayed copy of
+                const int first = jmin(numSamples, DELAY_BUFFER_LENGTH - (int) writeidx);
+                data.copyTo(chan, (int) writeidx, convolved, first);
+                if (first < numSamples) data.copyTo(chan, 0, convolved + first, numSamples - first);
+
+                float* channels[] = { convolved };
+                dsp::AudioBlock<float> block(channels, 1, (size_t) numSamples);
+                staticConvolvers[chan]->process(dsp::ProcessContextReplacing<float>(block));
+
+                if (convolutionGain >= 1.0)
+                {
+                    FloatVectorOperations::add(out, convolved, numSamples);
+                    timer.lapShared(staticTapIndices.data(), numStaticTaps, TapCostSnapshot::Read);
+                    continue;
+                }
+
+                if (convolutionGain > 0.0 || convolutionGainStep > 0.0)
+                {
+                    firOut = convolved + blocksize;
+                    FloatVectorOperations::clear(firOut, numSamples);
+                }
+            }
+        }
+
+        // adds one contiguous run of a tap's window to out, in place if the buffer allows it, and meters it while it's in cache
+        auto addRun = [&] (int t, int readidx, T* dest, int num, T mix)
+        {
+            const T* src = data.getContiguousReadPointer(chan, readidx);
+
+            if (src == nullptr)
+            {
+                data.copyTo(chan, readidx, window, num);
+                src = window;
+            }
+
+            FloatVectorOperations::addWithMultiply(dest, src, mix, num);
+
+            float peak = 0.0f, sumOfSquares = 0.0f;
+            accumulateLevel(src, num, peak, sumOfSquares);
+            tapLevels[chan].peaks[t] = jmax(tapLevels[chan].peaks[t], peak * (float) std::abs(mix));
+            tapLevels[chan].sumsOfSquares[t] += sumOfSquares * (float) (mix * mix);
+        };
+
+        for (int i = 0; i < numStaticTaps; ++i)
+        {
+            const int t = staticTapIndices[i];
+            const T mix = (T) (*runningTaps)[t]->getMix();
+
+            // the part of the window from before anything was written is silent, so it is skipped rather than read
+            const int offset = tapOffsets[t * blocksize];
+            const int unwritten = jlimit(0, numSamples, offset - writtenHistory);
+            const int num = numSamples - unwritten;
+
+            int readidx = (int) writeidx - offset + unwritten;
+            if (readidx < 0) readidx += DELAY_BUFFER_LENGTH;
+
+            // the window can run off the end of the buffer, in which case it's read in two runs
+            const int first = jmin(num, DELAY_BUFFER_LENGTH - readidx);
+            if (first > 0) addRun(t, readidx, firOut + unwritten, first, mix);
+            if (first < num) addRun(t, 0, firOut + unwritten + first, num - first, mix);
+
+            timer.lap(t, TapCostSnapshot::Read);
+        }
+
+        if (firOut != out)
+        {
+            // out += fir + gain * (convolved - fir), with the gain ramping linearly from the FIR to the convolvers
+            FloatVectorOperations::add(out, firOut, numSamples);
+            FloatVectorOperations::subtract(convolved, firOut, numSamples);
+
+            for (int s = 0; s < numSamples; ++s) out[s] += convolved[s] * (T) jmin(1.0, convolutionGain + s * convolutionGainStep);
+        }
+    }
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::updateHistory(int numSamples) noexcept
+{
+    MULTIDLY_TRACE_SCOPE("history summary")
+
+    // Every tap has added its feedback by now, so this part of the buffer won't change until it is overwritten a lap
+    // from now. The chunk was just written and read, so it is still in cache.
+    for (int start = (int) writeidx, remaining = numSamples; remaining > 0; start = 0)
+    {
+        const int n = jmin(remaining, DELAY_BUFFER_LENGTH - start); // the chunk may wrap round to the start of the buffer
+        std::array<const T*, Ch> channels;
+
+        for (int chan = 0; chan < Ch; ++chan)
+        {
+            channels[chan] = data.getContiguousReadPointer(chan, start);
+
+            // the static tap window is free again once the taps are done with it
+            if (channels[chan] == nullptr)
+            {
+                T* window = staticTapWindow.get() + chan * blocksize;
+                data.copyTo(chan, start, window, n);
+                channels[chan] = window;
+            }
+        }
+
+        history.write(start, channels.data(), Ch, n);
+        remaining -= n;
+    }
+
+    for (int t = 0; t < MAX_NUM_DLY_TAPS; ++t)
+    {
+        history.setMarker(t, taps[t] != nullptr ? tapOffsets[t * blocksize + (tapIsStatic[t] ? 0 : numSamples - 1)] : -1);
+    }
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::publishLevels() noexcept
+{
+    if (meteredSamples == 0) return;
+
+    LevelSnapshot& snapshot = levels.getWriteBuffer();
+    snapshot.blockIndex = ++blockCounter;
+    snapshot.numChannels = Ch;
+    snapshot.numTaps = 0;
+
+    auto toLevel = [] (float peak, float sumOfSquares, int numSamples)
+    {
+        return LevelSnapshot::Level { peak, std::sqrt(sumOfSquares / (float) numSamples) };
+    };
+
+    for (int t = 0; t < MAX_NUM_DLY_TAPS; ++t)
+    {
+        if (taps[t] != nullptr)
+        {
+            float peak = 0.0f, sumOfSquares = 0.0f;
+
+            for (int chan = 0; chan < Ch; ++chan)
+            {
+                peak = jmax(peak, tapLevels[chan].peaks[t]);
+                sumOfSquares += tapLevels[chan].sumsOfSquares[t];
+            }
+
+            snapshot.taps[snapshot.numTaps++] = { taps[t].get(), toLevel(peak, sumOfSquares, meteredSamples * Ch) };
+        }
+    }
+
+    for (int chan = 0; chan < Ch; ++chan)
+    {
+        snapshot.input[chan] = toLevel(inputPeaks[chan], inputSumsOfSquares[chan], meteredSamples);
+        snapshot.output[chan] = toLevel(outputPeaks[chan], outputSumsOfSquares[chan], meteredSamples);
+    }
+
+    levels.publish();
+
+    for (auto& channelLevels : tapLevels)
+    {
+        channelLevels.peaks.fill(0.0f);
+        channelLevels.sumsOfSquares.fill(0.0f);
+    }
+
+    inputPeaks.fill(0.0f);
+    inputSumsOfSquares.fill(0.0f);
+    outputPeaks.fill(0.0f);
+    outputSumsOfSquares.fill(0.0f);
+    meteredSamples = 0;
+}
+
+
+template<class T, int Ch>
+bool MultiDlyEngine<T, Ch>::getLatestLevels(LevelSnapshot& dest)
+{
+    levels.update();
+    dest = levels.getReadBuffer();
+    return dest.blockIndex > 0;
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::mergeTapCosts(const TapStageTimer& timer) noexcept
+{
+   #if MULTIDLY_TAP_PROFILING
+    for (int t = 0; t < MAX_NUM_DLY_TAPS; ++t)
+    {
+        for (int stage = 0; stage < TapCostSnapshot::NumStages; ++stage)
+        {
+            if (const uint64 c = timer.getCycles(t, stage)) tapCycleTotals[t][stage].fetch_add(c, std::memory_order_relaxed);
+        }
+    }
+   #else
+    ignoreUnused(timer);
+   #endif
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::publishTapCosts(int numSamples) noexcept
+{
+   #if MULTIDLY_TAP_PROFILING
+    MULTIDLY_TRACE_SCOPE("tap cost snapshot")
+
+    TapCostSnapshot& snapshot = tapCosts.getWriteBuffer();
+    snapshot.numTaps = 0;
+    snapshot.chunkIndex = chunkCounter;
+
+    // every channel group has finished by now, so the totals are complete
+    for (int t = 0; t < MAX_NUM_DLY_TAPS; ++t)
+    {
+        if (taps[t] == nullptr) continue;
+
+        auto& entry = snapshot.taps[snapshot.numTaps++];
+        entry.tapId = taps[t].get();
+        entry.samples = (int64) numSamples * Ch;
+
+        for (int stage = 0; stage < TapCostSnapshot::NumStages; ++stage)
+        {
+            entry.cycles[stage] = tapCycleTotals[t][stage].exchange(0, std::memory_order_relaxed);
+        }
+    }
+
+    tapCosts.publish();
+   #else
+    ignoreUnused(numSamples);
+   #endif
+}
+
+
+template<class T, int Ch>
+bool MultiDlyEngine<T, Ch>::getLatestTapCosts(TapCostSnapshot& dest)
+{
+   #if MULTIDLY_TAP_PROFILING
+    tapCosts.update();
+    dest = tapCosts.getReadBuffer();
+    return dest.chunkIndex > 0;
+   #else
+    ignoreUnused(dest);
+    return false;
+   #endif
+}
+
+
+template<class T, int Ch>
+uint32 MultiDlyEngine<T, Ch>::computeStaticTapSignature() const
+{
+    // FNV-1a over each static tap's offset and mix
+    uint32 hash = 2166136261u;
+
+    auto addBytes = [&hash] (const void* bytes, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= static_cast<const uint8*>(bytes)[i];
+            hash *= 16777619u;
+        }
+    };
+
+    for (int i = 0; i < numStaticTaps; ++i)
+    {
+        const int t = staticTapIndices[i];
+        const T mix = (T) (*runningTaps)[t]->getMix();
+
+        addBytes(&tapOffsets[t * blocksize], sizeof(int));
+        addBytes(&mix, sizeof(T));
+    }
+
+    return hash | 1; // zero means "nothing built"
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::requestStaticTapImpulseResponse()
+{
+    const uint32 version = requestedSpecVersion.load();
+    requestedSpecVersion.store(version + 1); // odd, so the background thread knows to leave requestedSpec alone
+
+    requestedSpec.numTaps = numStaticTaps;
+    requestedSpec.id = staticTapResponseId;
+
+    for (int i = 0; i < numStaticTaps; ++i)
+    {
+        const int t = staticTapIndices[i];
+        requestedSpec.offsets[i] = tapOffsets[t * blocksize];
+        requestedSpec.mixes[i] = (T) (*runningTaps)[t]->getMix();
+    }
+
+    requestedSpecVersion.store(version + 2);
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::updateStaticTapConvolution()
+{
+    // a convolver only swaps responses inside process(), which only this thread calls, so these are exact until it's next run
+    for (int chan = 0; chan < staticConvolvers.size(); ++chan)
+        runningResponseLengths[chan].store(staticConvolvers[chan]->getCurrentIRSize(), std::memory_order_relaxed);
+
+    if (numStaticTaps >= CONVOLUTION_MIN_STATIC_TAPS && ! staticConvolvers.isEmpty())
+    {
+        const uint32 signature = computeStaticTapSignature();
+
+        if (signature != staticTapSignature)
+        {
+            // the convolvers hold the wrong response until the new one is in, so the FIR takes straight back over
+            staticTapSignature = signature;
+            if (++numStaticTapRequests == 0) ++numStaticTapRequests;
+            staticTapResponseId = numStaticTapRequests;
+            convolutionWarmup = -1;
+            convolutionFade = 0;
+            requestStaticTapImpulseResponse();
+        }
+    }
+    else if (staticTapSignature != 0)
+    {
+        // Convolvers that miss a chunk have a hole in their history, so rather than being paused they are dropped, and
+        // coming back to the same taps builds, swaps in and warms up a fresh response.
+        staticTapSignature = 0;
+        convolutionWarmup = -1;
+        convolutionFade = 0;
+    }
+
+    feedConvolvers = (staticTapSignature != 0);
+    convolutionGain = 0.0;
+    convolutionGainStep = 0.0;
+
+    if (! feedConvolvers) return;
+
+    if (convolutionWarmup < 0)
+    {
+        const uint64 loaded = loadedResponse.load(std::memory_order_acquire);
+        const int length = (int) (loaded & 0xffffffff);
+        bool swappedIn = ((uint32) (loaded >> 32) == staticTapResponseId);
+
+        for (int chan = 0; chan < staticConvolvers.size() && swappedIn; ++chan)
+            swappedIn = (runningResponseLengths[chan].load(std::memory_order_relaxed) == length);
+
+        if (swappedIn)
+        {
+            // the new engines started with no history, so they need to be fed the whole response before it's complete
+            convolutionWarmup = length + roundToInt(sr * CONVOLUTION_SETTLE_SECONDS);
+            confirmedResponseId.store(staticTapResponseId);
+        }
+    }
+
+    if (convolutionWarmup == 0)
+    {
+        convolutionGain = (double) convolutionFade / blocksize;
+        convolutionGainStep = 1.0 / blocksize;
+        convolutionFade = jmin(blocksize, convolutionFade + currentNumSamples);
+    }
+    else if (convolutionWarmup > 0)
+    {
+        convolutionWarmup = jmax(0, convolutionWarmup - currentNumSamples);
+    }
+}
+
+
+template<class T, int Ch>
+int MultiDlyEngine<T, Ch>::useTimeSlice()
+{
+    if (resampling) return resampleHistoryChunk();
+
+    if constexpr (! std::is_same<T, float>::value)
+    {
+        return -1; // there are no convolvers to build for
+    }
+    else
+    {
+        const uint32 version = requestedSpecVersion.load();
+        if ((version & 1) != 0) return 1; // the audio thread is writing a new request right now
+
+        const StaticTapSpec spec = requestedSpec;
+        if (requestedSpecVersion.load() != version) return 1; // and it started another one while we were copying
+
+        if (spec.numTaps == 0 || spec.id == builtResponseId || staticConvolvers.isEmpty()) return 20;
+
+        MULTIDLY_TRACE_SCOPE("static tap IR")
+
+        int length = 1;
+        for (int i = 0; i < spec.numTaps; ++i) length = jmax(length, spec.offsets[i] + 1);
+
+        // The audio thread tells that a response has been swapped in by its length, so it's padded until it's different
+        // from every response a convolver could still be running: the ones they were running when the audio thread last
+        // looked, and any handed over since then which haven't been confirmed.
+        if (confirmedResponseId.load() == builtResponseId) unconfirmedLengths.clearQuick();
+
+        auto isInUse = [this] (int l)
+        {
+            for (auto& running : runningResponseLengths) if (running.load(std::memory_order_relaxed) == l) return true;
+            return unconfirmedLengths.contains(l);
+        };
+
+        while (isInUse(length)) ++length;
+        unconfirmedLengths.add(length);
+
+        AudioBuffer<float> ir(1, length);
+        ir.clear();
+        for (int i = 0; i < spec.numTaps; ++i) ir.addSample(0, spec.offsets[i], spec.mixes[i]);
+
+        // each convolver takes ownership of its own copy, and swaps it in on its message queue's thread some time later
+        for (auto* c : staticConvolvers)
+        {
+            AudioBuffer<float> copy(ir);
+            c->loadImpulseResponse(std::move(copy), sr, dsp::Convolution::Stereo::no, dsp::Convolution::Trim::no, dsp::Convolution::Normalise::no);
+        }
+
+        builtResponseId = spec.id;
+        loadedResponse.store(((uint64) spec.id << 32) | (uint64) length, std::memory_order_release);
+
+        return 0;
+    }
+}
+
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::startHistoryResample(double oldRate)
+{
+    // waits for any slice in progress, which may be of an earlier resample
+    backgroundThread->removeTimeSliceClient(this);
+
+    // if an earlier resample hasn't finished, its source is still the whole of the history, so it is simply retargeted
+    if (! resampling)
+    {
+        const int numSamples = (int) jmin((int64) DELAY_BUFFER_LENGTH, totalSamplesWritten.load());
+        const int oldest = ((int) writeidx - numSamples + DELAY_BUFFER_LENGTH) % DELAY_BUFFER_LENGTH;
+
+        resampleSource.malloc((size_t) Ch * (size_t) numSamples);
+        resampleSourceLength = numSamples;
+        resampleSourceRate = oldRate;
+
+        for (int chan = 0; chan < Ch; ++chan)
+        {
+            resampleDither[chan] = 0x85ebca6bu * (uint32) (chan + 1); // any non-zero seed will do
+
+            T* dest = resampleSource.get() + (size_t) chan * (size_t) numSamples;
+            const int a = jmin(numSamples, DELAY_BUFFER_LENGTH - oldest);
+
+            data.copyTo(chan, oldest, dest, a);
+            if (a < numSamples) data.copyTo(chan, 0, dest + a, numSamples - a);
+        }
+    }
+
+    const double ratio = resampleSourceRate / sr;
+    historyResampler.setRatio(ratio);
+
+    resampleLength = (int) jmin((double) DELAY_BUFFER_LENGTH, std::floor((resampleSourceLength - 1) / ratio) + 1.0);
+    resampleDone = 0;
+    resampleEndIndex = (int) writeidx;
+    resampleStartSamplesWritten = totalSamplesWritten.load();
+    resampleScratch.malloc(RESAMPLE_CHUNK_SAMPLES);
+    resampling = true;
+
+    // zeroed rather than released, so the memory stays committed for both the resampler and the audio thread
+    data.clear(false);
+
+    backgroundThread->addTimeSliceClient(this);
+}
+
+
+template<class T, int Ch>
+int MultiDlyEngine<T, Ch>::resampleHistoryChunk()
+{
+    MULTIDLY_TRACE_SCOPE("history resample")
+
+    // the audio thread carries on from resampleEndIndex, over the oldest of the history, so the resampled history has to
+    // stop well short of wherever it has got to. What it has overwritten was too old for any tap to reach anyway.
+    const int64 overwritten = totalSamplesWritten.load(std::memory_order_acquire) - resampleStartSamplesWritten;
+    const int end = (int) jlimit((int64) 0, (int64) resampleLength, (int64) DELAY_BUFFER_LENGTH - RESAMPLE_GUARD_SAMPLES - overwritten);
+
+    if (resampleDone >= end)
+    {
+        resampling = false;
+        resampleSource.free();
+        return 0;
+    }
+
+    const int numSamples = jmin(RESAMPLE_CHUNK_SAMPLES, end - resampleDone);
+
+    // this chunk is the samples [resampleDone, resampleDone + numSamples) before resampleEndIndex, written oldest first
+    const int startIndex = (resampleEndIndex - resampleDone - numSamples + 2 * DELAY_BUFFER_LENGTH) % DELAY_BUFFER_LENGTH;
+    const int a = jmin(numSamples, DELAY_BUFFER_LENGTH - startIndex);
+    const double ratio = resampleSourceRate / sr;
+    const double newest = resampleSourceLength - 1;
+
+    for (int chan = 0; chan < Ch; ++chan)
+    {
+        const T* source = resampleSource.get() + (size_t) chan * (size_t) resampleSourceLength;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const int age = resampleDone + numSamples - 1 - i; // in samples at the new rate, 0 being the newest
+            resampleScratch[i] = historyResampler.getSample(source, resampleSourceLength, newest - age * ratio);
+        }
+
+        data.copyFrom(chan, startIndex, resampleScratch.get(), a, &resampleDither[chan]);
+        if (a < numSamples) data.copyFrom(chan, 0, resampleScratch.get() + a, numSamples - a, &resampleDither[chan]);
+    }
+
+    resampleDone += numSamples;
+
+    return 0;
 }
 
+
+// assumes that numSamples < data.getNumSamples()
 template<class T, int Ch>
-MultiDlyEngine<T, Ch>::~MultiDlyEngine()
+void MultiDlyEngine<T, Ch>::writeIncomingAudio(const juce::AudioBuffer<T>& incomingAudio, int startSample, int numSamples, int firstChan, int lastChan)
 {
+    if (numSamples <= 0) return; // do nothing if incoming buffer is empty
+    assert(incomingAudio.getNumChannels() == data.getNumChannels()); // ensure number of channels is equal
+
+    const int a = jmin(numSamples, DELAY_BUFFER_LENGTH - (int) writeidx); // first batch of samples, up to the end of the buffer
+    const int b = numSamples - a; // second batch of samples, wrapped round to the start
+
+    for (int chan = firstChan; chan < lastChan; ++chan) // iterates through channels
+    {
+        // copies the first a samples, allowing us to copy b to. This overwrites rather than adds, because the sample
+        // at the write index is one whole buffer old and can no longer be read by any tap.
+        data.copyFrom(chan, writeidx, incomingAudio.getReadPointer(chan, startSample), a);
 
+        // when there are are extra overlapping samples, this puts them in the right place.
+        if (b != 0) data.copyFrom(chan, 0, incomingAudio.getReadPointer(chan, startSample) + a, b);
+    }
 }
 
 
 template<class T, int Ch>
-void MultiDlyEngine<T, Ch>::prepareToPlay(double sr, int block_size)
+bool MultiDlyEngine<T, Ch>::addDelayTap(std::shared_ptr<MultiDlyTap<T, Ch>> tapToAdd, unsigned int delayBufferSize)
 {
+    ignoreUnused(delayBufferSize);
 
-}
+    beginEdit();
+
+    // checks to ensure that the tap will fit within the array
+    const bool fits = (standbyNumTaps < MAX_NUM_DLY_TAPS);
+
+    // add tap to the edited set. Empty slots are always sorted to the end, so standbyNumTaps is the first free one.
+    if (fits)
+    {
+        tapToAdd->hostSlot = -1; // it takes a free slot, rather than one another tap already has
+        standbyTaps[standbyNumTaps++] = tapToAdd;
+    }
 
+    publishStandby(standbyCrossChannelFeedback);
+    return fits;
+}
 
 template<class T, int Ch>
-void MultiDlyEngine<T, Ch>::processSamples(AudioBuffer<T>& samples)
+std::shared_ptr<MultiDlyTap<T, Ch>> MultiDlyEngine<T, Ch>::createAndAddDelayTap(ValueTree delayTapParametersVT, unsigned int delayBufferSize)
 {
-    writeIncomingAudio(samples); // although the write happens here, the write index is incremented later.
+    ignoreUnused(delayBufferSize);
 
+    beginEdit();
 
+    std::shared_ptr<MultiDlyTap<T, Ch>> a = (standbyNumTaps < MAX_NUM_DLY_TAPS ? claimPooledTap() : nullptr);
 
-    for (int samp = 0; samp < samples.getNumSamples(); ++samp)
+    if (a != nullptr)
     {
-        for (int chan = 0; chan < samples.getNumChannels(); ++chan)
-        {
-            for (std::shared_ptr<MultiDlyTap<T,numChannels>> a : taps)
-            {
-                if (a == nullptr) continue; // weed out nullptr taps if applicable
-                int tapSamps = (a->getTimeMsSmoothedValue()->getNextValue() * 1000) * sr; // gets the tap time in samples, incrementing the smoothing on the smoothvalue
+        a->fromVTWithoutReset(delayTapParametersVT);
+        a->hostSlot = -1;
+        standbyTaps[standbyNumTaps++] = a; // copying a shared_ptr only bumps its count
+    }
+
+    publishStandby(standbyCrossChannelFeedback);
+    return a;
+}
 
-                int readidx = (writeidx - tapSamps); // gets the read index
-                if (readidx < 0) readidx = DELAY_BUFFER_LENGTH + readidx; // wraps the read index if necessary
+template<class T, int Ch>
+std::shared_ptr<MultiDlyTap<T, Ch>> MultiDlyEngine<T, Ch>::createAndAddDelayTap(const TapRecord& record)
+{
+    beginEdit();
 
-                T outval = data.getSample(chan, readidx); // gets initial read value
+    std::shared_ptr<MultiDlyTap<T, Ch>> a = (standbyNumTaps < MAX_NUM_DLY_TAPS ? claimPooledTap() : nullptr);
 
+    if (a != nullptr)
+    {
+        a->fromRecordWithoutReset(record);
+        a->hostSlot = -1;
+        standbyTaps[standbyNumTaps++] = a;
+    }
 
-                // called here because the filter could be switched to output by another thread during processing, however unlikely.
-                const bool filtpre = a->getFiltPre();
+    publishStandby(standbyCrossChannelFeedback);
+    return a;
+}
 
-                // FILTER //
-                if (filtpre)
-                {
-                    outval = a->lpFilter.processSample(0, outval);
-                    outval = a->hpFilter.processSample(0, outval);
-                }
+template<class T, int Ch>
+int MultiDlyEngine<T, Ch>::addTapAt(double timeMs)
+{
+    TapRecord record;
+    record.timeMs = jlimit(0.0, MAX_DELAY_TIME_SECONDS * 1000.0, timeMs);
 
-                T fdbkval = std::copy(outval);
+    // publishStandby() gives the tap its slot before createAndAddDelayTap() returns
+    auto a = createAndAddDelayTap(record);
+    return a != nullptr ? a->getHostSlot() : -1;
+}
 
-                // WAVESHAPING //
-                if (a->getWSIn())
-                {
-                    outval = a->pwaveshaper.load()->processSample(outval * a->getWSPreGain()) * a->getWSPostGain(); // runs the waveshaper on the outval
+template<class T, int Ch>
+std::shared_ptr<MultiDlyTap<T, Ch>> MultiDlyEngine<T, Ch>::claimPooledTap() noexcept
+{
+    const int slot = claimTapSlot();
+    if (slot < 0) return nullptr;
 
-                    // conditionally run the feedback value through the waveshaper
-                    if (a->getWSFdbk()) { fdbkval = a->pwaveshaper.load()->processSample(fdbkval * a->getWSPreGain()) * a->getWSPostGain(); }
-                }
+    // a slot is only freed once the audio thread has swapped its tap out of every set it runs, so nothing can be running
+    // the tap while it is recycled.
+    tapPool[slot]->reset();
+    return tapPool[slot];
+}
 
-                // COMPRESSION //
-                if (a->getCompIn())
-                {
-                    outval = a->comp.processSample(chan, outval); // runs the compressor on the outval
 
-                    // process feedback data on chan 1 so that it doesn't interfere.
-                    if (a->getCompFdbk()) { fdbkval = a->comp.processSample(chan*2, outval); }
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::acquireStandby() noexcept
+{
+    // an edit or load that hasn't been swapped in yet is replaced rather than faded through
+    holdStandby();
+    reclaimStandby();
 
-                }
+    standbyFades = true;
+}
 
-                // FILTER (if filter is in post)
-                if (! filtpre)
-                {
-                    outval = a->lpFilter[chan].processSample(chan, outval);
-                    outval = a->hpFilter[chan].processSample(chan, outval);
-                    fdbkval = a->lpFilter[chan].processSample(chan * 2, fdbkval);
-                    fdbkval = a->hpFilter[chan].processSample(chan * 2, fdbkval);
-                }
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::publishStandby(bool crossFeed) noexcept
+{
+    // slots are given out in the order the taps were loaded, before the sort puts them in time order
+    assignSlots(standbyTaps);
+    std::sort(standbyTaps.begin(), standbyTaps.end(), &MultiDlyTap<T, Ch>::compareTimes);
+    standbyCrossChannelFeedback = crossFeed;
 
+    standbyState.store(StandbyReady);
+}
 
-                data.addSample(chan, writeidx, fdbkval * a->getFeedback()); // adds feedback value to circular buffer
+template<class T, int Ch>
+bool MultiDlyEngine<T, Ch>::holdReadyStandby() noexcept
+{
+    int expected = StandbyReady;
+    return standbyState.compare_exchange_strong(expected, StandbyBuilding);
+}
 
-                samples.addSample(chan, samp, (outval * a->getMix()) + (samples.getSample(chan, readidx) * (1.0-a->getMix()))); // just does the mix math
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::assignSlots(TapSet& set) noexcept
+{
+    std::array<int, MAX_NUM_DLY_TAPS> slots;
+    int numTaps = 0;
 
-                // does denomral things
-                a->lpfilter.snapToZero();
-                a->hpfilter.snapToZero();
-            }
+    for (const auto& a : set)
+    {
+        if (a != nullptr) slots[(size_t) numTaps++] = a->hostSlot;
+    }
 
+    assignTapSlots(slots.data(), numTaps, MAX_NUM_DLY_TAPS);
 
-        }
-        ++writeidx;
+    numTaps = 0;
+    for (const auto& a : set)
+    {
+        if (a != nullptr) a->hostSlot = slots[(size_t) numTaps++];
     }
+}
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::mapTapSlots() noexcept
+{
+    tapsBySlot.fill(nullptr);
 
-    writeidx += samples.getNumSamples(); // add through write index.
+    for (const auto& a : taps)
+    {
+        if (a != nullptr && isPositiveAndBelow(a->hostSlot, MAX_NUM_DLY_TAPS)) tapsBySlot[(size_t) a->hostSlot] = a.get();
+    }
 }
 
+template<class T, int Ch>
+int MultiDlyEngine<T, Ch>::holdStandby() noexcept
+{
+    for (;;)
+    {
+        int expected = StandbyEmpty;
+        if (standbyState.compare_exchange_strong(expected, StandbyBuilding)) return StandbyEmpty;
+
+        if (holdReadyStandby()) return StandbyReady;
+
+        // the audio thread is swapping sets, or another thread is building or reading one, neither of which takes long
+        Thread::yield();
+    }
+}
 
-// assumes that the incomingAudio.getNumSamples() < data.getNumSamples()
 template<class T, int Ch>
-void MultiDlyEngine<T, Ch>::writeIncomingAudio(juce::AudioBuffer<float>& incomingAudio)
+void MultiDlyEngine<T, Ch>::releaseTap(std::shared_ptr<MultiDlyTap<T, Ch>>& a) noexcept
 {
-    if (incomingAudio.getNumSamples() <= 0) return; // do nothing if incoming buffer is empty
-    assert(incomingAudio.getNumChannels() == data.getNumChannels()); // ensure number of channels is equal
+    if (a == nullptr) return;
+
+    releaseStages(*a);
 
-    a = (writeidx + incomingAudio.getNumSamples()) % data.getNumSamples(); // first batch of samples
-    b = incomingAudio.getNumSamples() - a; // second batch of samples
+    const int slot = a->poolSlot;
+    a = nullptr;
 
-    for (int chan = 0; chan < incomingAudio.getNumChannels(); ++chan) // iterates through channels
+    if (slot >= 0) releaseTapSlot(slot);
+}
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::releaseStages(MultiDlyTap<T, Ch>& a) noexcept
+{
+    // nothing runs the tap's stages any more, so they go straight back rather than waiting for it to be reclaimed
+    if (a.filters != nullptr) { stageArena.release(a.filters); a.filters = nullptr; }
+    if (a.comp != nullptr) { stageArena.release(a.comp); a.comp = nullptr; }
+}
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::retireFadingTaps() noexcept
+{
+    for (auto& a : fadingTaps)
     {
-        // copies the first a samples, allowing us to copy b to
-        data.addFrom(chan, writeidx, incomingAudio.getReadPointer(chan), a);
+        if (a == nullptr) continue;
 
-        // when there are are extra overlapping samples, this puts them in the right place.
-        if (b != 0) data.addFrom(chan, 0, incomingAudio.getReadPointer(chan)+a, b);
+        // The pool still owns a pooled tap, so dropping it here frees nothing. A tap from addDelayTap() may have no
+        // other owner, so it is kept, and the next load's swap moves it into standbyTaps, where the message thread's
+        // reclaimStandby() drops it.
+        if (a->poolSlot >= 0) releaseTap(a);
+        else releaseStages(*a);
     }
 }
 
+template<class T, int Ch>
+bool MultiDlyEngine<T, Ch>::isInActiveSet(const std::shared_ptr<MultiDlyTap<T, Ch>>& a) const noexcept
+{
+    return std::find(taps.begin(), taps.end(), a) != taps.end();
+}
 
 template<class T, int Ch>
-bool MultiDlyEngine<T, Ch>::addDelayTap(std::shared_ptr<MultiDlyTap<T, Ch>> tapToAdd, unsigned int delayBufferSize)
+void MultiDlyEngine<T, Ch>::reclaimStandby() noexcept
 {
-    // checks to ensure that the tap will fit within the array
-    if (num_taps == MAX_NUM_DLY_TAPS) return false;
+    // Whatever is here is either a set that was never swapped in, the set an edit replaced, or the taps from outside the
+    // pool a finished crossfade left behind. Taps still in the active set are only dropped from this one; the rest aren't
+    // run by anything, so they go back to the pool.
+    for (auto& a : standbyTaps)
+    {
+        if (a != nullptr && isInActiveSet(a)) a = nullptr;
+        else releaseTap(a);
+    }
 
-    if (delayBufferSize == 0) delayBufferSize = DELAY_BUFFER_LENGTH;
+    standbyNumTaps = 0;
+}
 
-    // add tap to taps -- is this the correct operation? does it add to the shared_ptr ref count?
-    taps[num_taps] = tapToAdd;
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::beginEdit() noexcept
+{
+    // an edit to a set still waiting to be swapped in just changes that set, and it is swapped in as it would have been
+    if (holdStandby() == StandbyReady) return;
 
-    // tap has been added
-    ++num_taps;
+    reclaimStandby();
 
-    // sorts taps based on their () operator, which gets time.
-    std::sort(taps.begin(), taps.end(), MultiDlyTap<T, Ch>());
+    standbyTaps = taps;
+    standbyNumTaps = num_taps;
+    standbyCrossChannelFeedback = crossChannelFeedback;
+    standbyFades = false;
 }
 
 template<class T, int Ch>
-std::shared_ptr<MultiDlyTap<T, Ch>> MultiDlyEngine<T, Ch>::createAndAddDelayTap(ValueTree delayTapParametersVT, unsigned int delayBufferSize)
+void MultiDlyEngine<T, Ch>::removeStandbyTap(int index) noexcept
 {
-    if (num_taps == MAX_NUM_DLY_TAPS) return std::make_shared<MultiDlyTap<T, Ch>>(nullptr); // returns a shared nullptr. comparison between shared_ptr<T> and nullptr, still supported in c++20 although other comparison operators are now removed
+    if (! isPositiveAndBelow(index, MAX_NUM_DLY_TAPS) || standbyTaps[(size_t) index] == nullptr) return;
 
+    // a tap the audio thread is running stays claimed until it has been swapped out, and is handed back by reclaimStandby()
+    if (isInActiveSet(standbyTaps[(size_t) index])) standbyTaps[(size_t) index] = nullptr;
+    else releaseTap(standbyTaps[(size_t) index]);
 
-    if (delayBufferSize == 0) delayBufferSize = DELAY_BUFFER_LENGTH;
+    --standbyNumTaps;
+}
 
-    std::shared_ptr<MultiDlyTap<T, Ch>> a = std::make_shared<MultiDlyTap<T, Ch>>(*this, delayBufferSize);
-    a->fromVTWithoutReset(delayTapParametersVT);
 
-    if (a != nullptr)
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::getState(MemoryBlock& dest)
+{
+    // Held for the whole copy, so the audio thread can't swap a load in half way through. A load that hasn't been
+    // swapped in yet is still the newest state.
+    const int held = holdStandby();
+    const bool pending = (held == StandbyReady);
+    const TapSet& source = pending ? standbyTaps : taps;
+
+    StateHeader header;
+    header.headerSize = sizeof(StateHeader);
+    header.recordSize = sizeof(TapRecord);
+    header.flags = (pending ? standbyCrossChannelFeedback : crossChannelFeedback) ? StateHeader::CrossChannelFeedback : 0u;
+
+    // one pass over the set, so the count the block is sized by is the count of the records written into it
+    std::array<TapRecord, MAX_NUM_DLY_TAPS> records;
+
+    for (const auto& a : source)
+    {
+        if (a != nullptr) a->toRecord(records[header.numTaps++]);
+    }
+
+    standbyState.store(held);
+
+    const size_t size = header.headerSize + (size_t) header.numTaps * header.recordSize;
+    if (dest.getSize() != size) dest.setSize(size);
+
+    char* out = static_cast<char*>(dest.getData());
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + header.headerSize, records.data(), (size_t) header.numTaps * sizeof(TapRecord));
+}
+
+template<class T, int Ch>
+bool MultiDlyEngine<T, Ch>::setState(const void* data, size_t sizeInBytes)
+{
+    StateHeader header;
+    if (! readStateHeader(data, sizeInBytes, header)) return false;
+
+    acquireStandby();
+
+    // every tap is added before sorting once, rather than sorting after each one as createAndAddDelayTap() does
+    for (int i = 0; i < (int) jmin(header.numTaps, (uint32) MAX_NUM_DLY_TAPS); ++i)
+    {
+        std::shared_ptr<MultiDlyTap<T, Ch>> a = claimPooledTap();
+        if (a == nullptr) break;
+
+        a->fromRecordWithoutReset(readTapRecord(data, header, i));
+        a->skipTimeSmoothing(); // the crossfade hides the change, so the tap starts at its time rather than gliding up from zero
+        standbyTaps[standbyNumTaps++] = a;
+    }
+
+    publishStandby((header.flags & StateHeader::CrossChannelFeedback) != 0);
+    return true;
+}
+
+template<class T, int Ch>
+ValueTree MultiDlyEngine<T, Ch>::getStateAsValueTree()
+{
+    const int held = holdStandby();
+    const bool pending = (held == StandbyReady);
+
+    ValueTree state("MultiDlyState", {{"crossChannelFeedback", pending ? standbyCrossChannelFeedback : crossChannelFeedback}});
+
+    for (const auto& a : pending ? standbyTaps : taps)
+    {
+        if (a != nullptr) state.appendChild(a->toVT(), nullptr);
+    }
+
+    standbyState.store(held);
+    return state;
+}
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::setStateFromValueTree(const ValueTree& state)
+{
+    if (! state.hasType("MultiDlyState")) return;
+
+    acquireStandby();
+
+    for (const auto& child : state)
+    {
+        if (! child.hasType("MultiDlyTap") || standbyNumTaps == MAX_NUM_DLY_TAPS) continue;
+
+        std::shared_ptr<MultiDlyTap<T, Ch>> a = claimPooledTap();
+        if (a == nullptr) break;
+
+        a->fromVTWithoutReset(child);
+        a->skipTimeSmoothing();
+        standbyTaps[standbyNumTaps++] = a;
+    }
+
+    publishStandby(state.getProperty("crossChannelFeedback", false));
+}
+
+template<class T, int Ch>
+int MultiDlyEngine<T, Ch>::claimTapSlot() noexcept
+{
+    for (int word = 0; word < (int) freeTapSlots.size(); ++word)
     {
-        taps[num_taps] = a;
-        ++num_taps;
+        uint32 free = freeTapSlots[word].load();
+
+        while (free != 0)
+        {
+            int bit = 0;
+            while ((free & (1u << bit)) == 0) ++bit;
+
+            if (freeTapSlots[word].compare_exchange_weak(free, free & ~(1u << bit))) return word * 32 + bit;
+        }
     }
 
-    // sorts taps based on their () operator, which gets time.
-    std::sort(taps.begin(), taps.end(), MultiDlyTap<T, Ch>());
+    return -1;
+}
 
-    return a; // returns even if a is nullptr
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::releaseTapSlot(int slot) noexcept
+{
+    jassert(slot >= 0 && slot < TAP_POOL_SIZE);
+    freeTapSlots[slot / 32].fetch_or(1u << (slot % 32));
 }
 
 template<class T, int Ch>
 void MultiDlyEngine<T, Ch>::setBlockSize(int newBlockSize)
 {
-    blocksize = newBlockSize;
+    blocksize = jmax(1, newBlockSize);
+
+
+    // each channel's row of the wet bus starts on its own cache line
+    wetBusStride = (int) (((size_t) blocksize * sizeof(T) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE / sizeof(T));
+    wetBusMemory.allocate((size_t) (2 + MAX_NUM_DLY_TAPS) * Ch * (size_t) wetBusStride * sizeof(T) + CACHE_LINE_SIZE, true);
+    wetBus = reinterpret_cast<T*>((reinterpret_cast<uintptr_t>(wetBusMemory.get()) + CACHE_LINE_SIZE - 1) & ~(uintptr_t) (CACHE_LINE_SIZE - 1));
+    chunkHistory = wetBus + (size_t) Ch * wetBusStride;
+    tapWet = chunkHistory + (size_t) Ch * wetBusStride;
+
+    // a native buffer is already read with a plain load, so only the compact formats need the windows
+    if (data.getFormat() != DelayBufferFormat::Native) tapWindows.allocate((size_t) MAX_NUM_DLY_TAPS * Ch * blocksize, true);
+
+    tapOffsets.allocate((size_t) MAX_NUM_DLY_TAPS * blocksize, true);
+    staticTapWindow.allocate((size_t) Ch * blocksize, true);
+    convolutionWindows.allocate((size_t) 2 * Ch * blocksize, true);
+    fadeGains.allocate((size_t) 2 * blocksize, true);
+}
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::setCrossChannelFeedback(bool shouldCrossFeed)
+{
+    // the channel groups read it all through a chunk, so it only changes when the audio thread swaps in the edited set
+    beginEdit();
+    publishStandby(shouldCrossFeed);
+}
+
+template<class T, int Ch>
+bool MultiDlyEngine<T, Ch>::getCrossChannelFeedback()
+{
+    // the newest setting, as getState() sees it
+    const int held = holdStandby();
+    const bool crossFeed = (held == StandbyReady ? standbyCrossChannelFeedback : crossChannelFeedback);
+    standbyState.store(held);
+
+    return crossFeed;
 }
 
 template<class T, int Ch>
 void MultiDlyEngine<T, Ch>::setSampleRate(double newSampleRate)
 {
     sr = newSampleRate;
-    for (std::shared_ptr<MultiDlyTap<T,numChannels>> a : taps)
+
+    stageArena.prepare(sr);
+
+    // pooled taps are prepared whether they're in use or not, so claiming one never has to.
+    for (const auto& a : tapPool)
     {
-        a->init();
+        if (a != nullptr) a->prepare();
+    }
+
+    for (const auto& a : taps)
+    {
+        if (a != nullptr && a->poolSlot < 0) a->prepare();
     }
 }
 
@@ -206,18 +1630,31 @@ double MultiDlyEngine<T, Ch>::getSampleRate() const
 template<class T, int Ch>
 void MultiDlyEngine<T, Ch>::removeTap(std::shared_ptr<MultiDlyTap<T, Ch>> tap)
 {
-    int i = 0;
-    for (std::shared_ptr<MultiDlyTap<T, Ch>> t : taps)
-    {
-        if (t == tap) { removeTap(i); }
-        ++i;
-    }
+    beginEdit();
+
+    auto it = std::find(standbyTaps.begin(), standbyTaps.end(), tap);
+    if (it != standbyTaps.end()) removeStandbyTap((int) (it - standbyTaps.begin()));
+
+    publishStandby(standbyCrossChannelFeedback);
 }
 
 template<class T, int Ch>
 void MultiDlyEngine<T, Ch>::removeTap(int index)
 {
-    taps[index] = nullptr;
+    beginEdit();
+    removeStandbyTap(index);
+    publishStandby(standbyCrossChannelFeedback);
+}
+
+template<class T, int Ch>
+void MultiDlyEngine<T, Ch>::removeTapInSlot(int slot)
+{
+    beginEdit();
+
+    auto it = std::find_if(standbyTaps.begin(), standbyTaps.end(), [slot] (const auto& a) { return a != nullptr && a->getHostSlot() == slot; });
+    if (it != standbyTaps.end()) removeStandbyTap((int) (it - standbyTaps.begin()));
+
+    publishStandby(standbyCrossChannelFeedback);
 }
 
 
@@ -225,5 +1662,183 @@ void MultiDlyEngine<T, Ch>::removeTap(int index)
 template<class T, int Ch>
 std::shared_ptr<MultiDlyTap<T, Ch>> MultiDlyEngine<T, Ch>::getTap(int index)
 {
-    return taps[index];
+    if (! isPositiveAndBelow(index, MAX_NUM_DLY_TAPS)) return nullptr;
+
+    // the newest set, as getState() sees it, and held so that it can't be swapped while the pointer is copied
+    const int held = holdStandby();
+    auto a = (held == StandbyReady ? standbyTaps : taps)[(size_t) index];
+    standbyState.store(held);
+
+    return a;
+}
+
+
+
+template <class T>
+std::shared_ptr<EngineBase> createMultiDlyEngine(int numChannels, double sampleRate, int blockSize, DelayBufferLayout layout, DelayBufferFormat format)
+{
+    switch (numChannels)
+    {
+        case 1: return std::make_shared<MultiDlyEngine<T, 1>>(sampleRate, blockSize, layout, format);
+        case 2: return std::make_shared<MultiDlyEngine<T, 2>>(sampleRate, blockSize, layout, format);
+        case 4: return std::make_shared<MultiDlyEngine<T, 4>>(sampleRate, blockSize, layout, format);
+        case 6: return std::make_shared<MultiDlyEngine<T, 6>>(sampleRate, blockSize, layout, format);
+        case 8: return std::make_shared<MultiDlyEngine<T, 8>>(sampleRate, blockSize, layout, format);
+        case 12: return std::make_shared<MultiDlyEngine<T, 12>>(sampleRate, blockSize, layout, format);
+        case 16: return std::make_shared<MultiDlyEngine<T, 16>>(sampleRate, blockSize, layout, format);
+        case 24: return std::make_shared<MultiDlyEngine<T, 24>>(sampleRate, blockSize, layout, format);
+        default: return nullptr;
+    }
+}
+
+// the engine is only ever created through createMultiDlyEngine(), so these are all the instantiations needed.
+template std::shared_ptr<EngineBase> createMultiDlyEngine<float>(int, double, int, DelayBufferLayout, DelayBufferFormat);
+
+
+#if MULTIDLY_LAYOUT_BENCHMARK
+String runLayoutBenchmark()
+{
+    constexpr int blockSize = 512;
+    String report = "layout benchmark, " + String(MAX_NUM_DLY_TAPS / 4) + " filtered taps, " + String(blockSize) + "-sample blocks, us per block:";
+
+    for (int numChannels : { 2, 6, 12 })
+    {
+        report << "\n  " << numChannels << " channels:";
+
+        for (auto layout : { DelayBufferLayout::Planar, DelayBufferLayout::Interleaved })
+        {
+            auto engine = createMultiDlyEngine<float>(numChannels, 48000.0, blockSize, layout);
+            if (engine == nullptr) return "no engine for " + String(numChannels) + " channels";
+
+            // the same taps for both layouts, spread across the first second of history
+            ValueTree state("MultiDlyState");
+            for (int t = 0; t < MAX_NUM_DLY_TAPS / 4; ++t)
+            {
+                state.appendChild(ValueTree("MultiDlyTap", {{"hpFilterFreq", 40.0}, {"lpFilterFreq", 8000.0}, {"hpFilterRes", 0.70710678}, {"lpFilterRes", 0.70710678},
+                                                             {"compRatio", 1.0}, {"compThresh", 0.0}, {"compAtk", 1.0}, {"compRel", 100.0}, {"compIn", false},
+                                                             {"wsType", 1}, {"wsPreGain", 1.0}, {"wsPostGain", 1.0}, {"wsIn", false}, {"compFdbk", false},
+                                                             {"wsFdbk", false}, {"filtPre", true}, {"filtIn", true}, {"mix", 0.5},
+                                                             {"feedback", 0.3}, {"timeMs", 37.0 + t * 113.0}}), nullptr);
+            }
+
+            engine->setCrossfadeTimeMs(0.0);
+            engine->setStateFromValueTree(state);
+
+            AudioBuffer<float> block(numChannels, blockSize);
+            Random random(1);
+
+            auto fill = [&]
+            {
+                for (int chan = 0; chan < numChannels; ++chan)
+                    for (int i = 0; i < blockSize; ++i) block.setSample(chan, i, random.nextFloat() * 2.0f - 1.0f);
+            };
+
+            // lets the taps swap in and the buffer's first pages be committed before timing starts
+            for (int i = 0; i < 100; ++i) { fill(); engine->processBlock(block); }
+
+            double seconds = 0.0;
+            for (int i = 0; i < LAYOUT_BENCHMARK_BLOCKS; ++i)
+            {
+                fill();
+                const int64 start = Time::getHighResolutionTicks();
+                engine->processBlock(block);
+                seconds += Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+            }
+
+            report << (layout == DelayBufferLayout::Planar ? " planar " : ", interleaved ") << String(seconds * 1.0e6 / LAYOUT_BENCHMARK_BLOCKS, 2);
+        }
+    }
+
+    return report;
+}
+#endif
+
+
+#if MULTIDLY_REALTIME_SELF_TEST
+String runRealtimeSelfTest()
+{
+    static_assert(MULTIDLY_REALTIME_CHECKS, "the self test needs the MULTIDLY_REALTIME_CHECKS option");
+
+    constexpr int blockSize = 512;
+
+    // taps spread from firstMs on, each with its filters, and its compressor if asked for
+    auto makeState = [] (int numTaps, double firstMs, bool withStages)
+    {
+        ValueTree state("MultiDlyState");
+
+        for (int t = 0; t < numTaps; ++t)
+        {
+            state.appendChild(ValueTree("MultiDlyTap", {{"hpFilterFreq", 40.0}, {"lpFilterFreq", 8000.0}, {"hpFilterRes", 0.70710678}, {"lpFilterRes", 0.70710678},
+                                                         {"compRatio", 4.0}, {"compThresh", -12.0}, {"compAtk", 1.0}, {"compRel", 100.0}, {"compIn", withStages},
+                                                         {"wsType", 1}, {"wsPreGain", 1.0}, {"wsPostGain", 1.0}, {"wsIn", withStages}, {"compFdbk", false},
+                                                         {"wsFdbk", false}, {"filtPre", true}, {"filtIn", withStages}, {"mix", 0.5},
+                                                         {"feedback", withStages ? 0.3 : 0.0}, {"timeMs", firstMs + t * 17.0}}), nullptr);
+        }
+
+        return state;
+    };
+
+    // from here on the first violation aborts, so getting to the end is the pass
+    MultiDlyRealtimeChecks::resetNumViolations();
+    MultiDlyRealtimeChecks::setAbortOnViolation(true);
+
+    int numEngines = 0;
+
+    for (int numChannels : { 2, 6 })
+    {
+        for (auto format : { DelayBufferFormat::Native, DelayBufferFormat::Half, DelayBufferFormat::Fixed16 })
+        {
+            auto engine = createMultiDlyEngine<float>(numChannels, 48000.0, blockSize, DelayBufferLayout::Planar, format);
+            if (engine == nullptr) continue;
+
+            AudioBuffer<float> block(numChannels, blockSize);
+            Random random(1);
+
+            auto process = [&] (int numBlocks, bool withEvents)
+            {
+                for (int i = 0; i < numBlocks; ++i)
+                {
+                    for (int chan = 0; chan < numChannels; ++chan)
+                        for (int samp = 0; samp < blockSize; ++samp) block.setSample(chan, samp, random.nextFloat() * 2.0f - 1.0f);
+
+                    // an editor dragging a control, from off the audio thread
+                    engine->setTapParameter(i % 4, TapParameter::Mix, random.nextFloat());
+                    if (i % 50 == 0) engine->setTapParameter(0, TapParameter::CompIn, (i / 50) % 2 == 0 ? 1.0f : 0.0f);
+
+                    MULTIDLY_REALTIME_SCOPE
+
+                    // host automation, timed within the block
+                    if (withEvents)
+                    {
+                        engine->queueParameterEvent({ 100, 1, TapParameter::TimeMs, 50.0f + (float) (i % 10) * 20.0f });
+                        engine->queueParameterEvent({ 300, 2, TapParameter::LpFreq, 2000.0f + (float) (i % 10) * 500.0f });
+                    }
+
+                    engine->processBlock(block);
+                }
+            };
+
+            engine->setStateFromValueTree(makeState(8, 37.0, true));
+            process(REALTIME_SELF_TEST_BLOCKS, true);
+
+            // crossfades to enough static taps to be convolved, while the convolver's impulse response is built and swapped in
+            engine->setStateFromValueTree(makeState(CONVOLUTION_MIN_STATIC_TAPS + 4, 11.0, false));
+            process(REALTIME_SELF_TEST_BLOCKS, false);
+
+            // and back, which hands the dense set's taps back to the pool
+            engine->setStateFromValueTree(makeState(8, 37.0, true));
+            process(REALTIME_SELF_TEST_BLOCKS, true);
+
+            // the history is resampled on the background thread while the audio thread carries on
+            engine->prepareToPlay(44100.0, blockSize);
+            process(REALTIME_SELF_TEST_BLOCKS, true);
+
+            ++numEngines;
+        }
+    }
+
+    MultiDlyRealtimeChecks::setAbortOnViolation(false);
+
+    return "realtime self test passed: " + String(numEngines) + " engines, " + String(MultiDlyRealtimeChecks::getNumViolations()) + " violations";
 }
+#endif
@@ -10,18 +10,161 @@
 
 #pragma once
 
+#ifndef MULTIDLY_LAYOUT_BENCHMARK
+ #define MULTIDLY_LAYOUT_BENCHMARK 0 // set for the MultiDlyTests target only
+#endif
+
+#ifndef MULTIDLY_REALTIME_SELF_TEST
+ #define MULTIDLY_REALTIME_SELF_TEST 0 // set for the MultiDlyTests target only
+#endif
+
 #define MAX_NUM_DLY_TAPS 32
 #define MAX_DELAY_TIME_SECONDS 20
 //#define INTERNAL_BLOCK_SIZE 32 // not needed currently, but might be if internal sub-block processing is necessary (to account for the smoothed value)
 #define DELAY_BUFFER_LENGTH (MAX_DELAY_TIME_SECONDS * 48000)
+#define PREFAULT_AHEAD_SAMPLES 48000 // how far ahead of the write index the delay buffer's memory is committed
+#define CONVOLUTION_MIN_STATIC_TAPS 16 // from this many static taps on, they are convolved rather than summed
+#define CONVOLUTION_HEAD_SIZE 256 // the size of the first, uniform, partitions of the non-uniformly partitioned convolution
+#define CONVOLUTION_SETTLE_SECONDS 0.06 // juce::dsp::Convolution crossfades to a new response over 50ms itself, which has to be over before its output is used
+#define TAP_POOL_SIZE (3 * MAX_NUM_DLY_TAPS) // enough for the active tap set, the one it is crossfading from, and a standby set being built
+#define DEFAULT_CROSSFADE_MS 50.0 // how long the engine crossfades from one tap set to the next when state is loaded
+#define LAYOUT_BENCHMARK_BLOCKS 2000 // how many 512-sample blocks each engine processes in runLayoutBenchmark()
+#define REALTIME_SELF_TEST_BLOCKS 400 // how many 512-sample blocks each engine processes in each phase of runRealtimeSelfTest()
+#define RESAMPLE_CHUNK_SAMPLES 4096 // how much delay history the background thread resamples per channel in one time slice
+#define RESAMPLE_GUARD_SAMPLES 48000 // how far the resampled history stays clear of the audio thread's write index
 
 
 #include "MultiDlyTap.h"
+#include "MultiDlyWorkerPool.h"
+#include "MultiDlyDelayBuffer.h"
+#include "MultiDlyBackgroundThread.h"
+#include "MultiDlyTapProfiler.h"
+#include "TripleBuffer.h"
+#include "MultiDlyTracer.h"
+#include "MultiDlyMeters.h"
+#include "MultiDlyHistoryPyramid.h"
+#include "MultiDlyDisplayStateManager.h"
+#include "MultiDlyTapParameters.h"
+#include "MultiDlyParameterTable.h"
+#include "MultiDlyHistoryResampler.h"
 #include <JuceHeader.h>
 
 
 
-class EngineBase {};
+/**
+ @brief The channel-count-independent interface to a MultiDlyEngine.
+
+ The processor only knows its channel count at prepareToPlay(), so it holds its engine through this interface and creates it with createMultiDlyEngine().
+ */
+class EngineBase
+{
+public:
+    virtual ~EngineBase() = default;
+
+    /// @brief See MultiDlyEngine::prepareToPlay().
+    virtual void prepareToPlay(double sr, int block_size) = 0;
+
+    /// @brief Processes a block from the host in place. The buffer must have exactly getNumChannels() channels.
+    virtual void processBlock(AudioBuffer<float>& samples) = 0;
+
+    /// @brief Gets the number of channels the engine was created with.
+    virtual int getNumChannels() const = 0;
+
+    /**
+     @brief Copies the newest per-tap cost snapshot into dest, returning false if there isn't one.
+
+     Snapshots are only made when built with MULTIDLY_TAP_PROFILING. Must only be called from one thread, normally the message thread.
+     */
+    virtual bool getLatestTapCosts(TapCostSnapshot& dest) { ignoreUnused(dest); return false; }
+
+    /**
+     @brief Copies the newest levels into dest, returning false if no block has been processed yet.
+
+     Must only be called from one thread, normally the message thread.
+     */
+    virtual bool getLatestLevels(LevelSnapshot& dest) = 0;
+
+    /**
+     @brief Gets the summary of the delay history, for drawing it. The audio thread keeps it up to date, and it can be read from any thread while the engine is alive.
+     */
+    virtual const MultiDlyHistoryPyramid& getHistory() const = 0;
+
+    /// @brief Gets the snapshot of tap states the engine publishes for the editors. It lives as long as the engine or the last pointer to it.
+    virtual std::shared_ptr<MultiDlyDisplayStateManagerBase> getDisplayStateManager() const = 0;
+
+    /// @brief Gets how many times a tap found no free filter or compressor stage to borrow, and so ran without it. Should always be zero; can be read from any thread.
+    virtual uint32 getNumStageAcquireFailures() const = 0;
+
+    /**
+     @brief Writes every tap, and the engine's own settings, to dest in the binary state format described in MultiDlyStateFormat.h.
+
+     dest is only reallocated if its size changes, so a caller which keeps the same block around makes repeated saves of the same taps without allocating.
+
+     Can be called from any thread but the audio thread, at the same time as a load. The audio thread can't swap a loaded set in while the taps are being copied, so the state is always one whole set.
+     */
+    virtual void getState(MemoryBlock& dest) = 0;
+
+    /**
+     @brief Replaces every tap with those in a block written by getState().
+
+     The new taps are built on the calling thread and handed to the audio thread, which crossfades to them over getCrossfadeTimeMs() at the start of its next chunk, so this never interrupts playback. Until then getState() returns the new taps. Must only be called from one thread, normally the message thread.
+
+     Returns false, changing nothing, if the block isn't in the binary format, so the caller can try reading it another way.
+     */
+    virtual bool setState(const void* data, size_t sizeInBytes) = 0;
+
+    /// @brief Gets the same state as getState(), as a `ValueTree` with a child for each tap, as made by MultiDlyTap::toVT().
+    virtual ValueTree getStateAsValueTree() = 0;
+
+    /// @brief Replaces every tap with those in a `ValueTree` made by getStateAsValueTree(), crossfading as setState() does. Does nothing if the tree is of the wrong type.
+    virtual void setStateFromValueTree(const ValueTree& state) = 0;
+
+    /**
+     @brief Sets how long the engine crossfades from its current taps to those loaded by setState() or setStateFromValueTree().
+
+     The fade is equal-power, and zero switches at a chunk boundary with no fade. Takes effect from the next load.
+
+     @param newCrossfadeMs The length of the crossfade, in milliseconds.
+     */
+    virtual void setCrossfadeTimeMs(double newCrossfadeMs) = 0;
+
+    /// @brief Gets the crossfade time set by setCrossfadeTimeMs().
+    virtual double getCrossfadeTimeMs() const = 0;
+
+    /**
+     @brief Queues a parameter change for the next processBlock(), to take effect at the event's sample offset within that block.
+
+     The block is processed in chunks split at each event's offset, so a change lands on exactly its sample without the rest of the block being processed any differently. Events for a slot with no tap in it are ignored. Offsets past the end of the block are applied at its end.
+
+     Must be called from the audio thread, before the processBlock() the event belongs to. Never allocates; beyond MAX_PARAMETER_EVENTS_PER_BLOCK events a block, later ones are applied at once.
+     */
+    virtual void queueParameterEvent(const TapParameterEvent& event) = 0;
+
+    /**
+     @brief Sets a parameter of one of the active set's taps at the start of the next block, from any thread.
+
+     Changes are coalesced: however often a parameter is set between two blocks, the audio thread applies only its latest value, once, so a dragged control can't restart a tap's time ramp more than once a block.
+
+     This is for code that drives an engine with no host around it, such as tools and tests. In the plugin, the host parameters are the one place a tap's settings are changed, so the editor goes through MultiDlyHostParameters::getParameter() instead; a change made here would never reach the host or its automation.
+
+     @param tap The host slot of the tap, see MultiDlyTap::getHostSlot(). Ignored if no tap has that slot when the change is applied.
+     @param parameter The parameter to set.
+     @param value The new value, in the units of the parameter's TapParameterInfo::range.
+     */
+    virtual void setTapParameter(int tap, TapParameter parameter, float value) = 0;
+
+    /**
+     @brief Adds a tap at a time, with every other setting at its default, returning the host slot it was given, or -1 if every tap is already in use.
+
+     The tap is added as MultiDlyEngine::createAndAddDelayTap() adds one, so this never allocates and must not be called from the audio thread.
+
+     @param timeMs The tap's time, in milliseconds.
+     */
+    virtual int addTapAt(double timeMs) = 0;
+
+    /// @brief Removes the tap with a host slot, see MultiDlyTap::getHostSlot(), doing nothing if no tap has it. Must not be called from the audio thread.
+    virtual void removeTapInSlot(int slot) = 0;
+};
 
 /**
  @brief The engine that runs delay processing, owns MultiDlyTaps, and represents the entire audio backend of the plugin.
@@ -30,26 +173,315 @@ class EngineBase {};
  @tparam Ch The number of channels to perform audio processing on (both input and output channels)
  */
 template <class T, int Ch>
-class MultiDlyEngine : public EngineBase
+class MultiDlyEngine : public EngineBase, private TimeSliceClient
 {
+    using TapSet = std::array<std::shared_ptr<MultiDlyTap<T, Ch>>, MAX_NUM_DLY_TAPS>;
+
     // stores shared ptrs to the taps, as they will also be owned by the display managerclass.
-    std::array<std::shared_ptr<MultiDlyTap<T, Ch>>, MAX_NUM_DLY_TAPS> taps;
+    TapSet taps;
     unsigned int num_taps = 0; // used to check if the max has been reached
 
-    double sr;
-    int blocksize;
-    int a, b; // used for copying samples
+    // Every tap createAndAddDelayTap() can hand out is created and prepared up front, so adding one while audio is
+    // running never touches the heap. A set bit in freeTapSlots means that slot of tapPool is free to claim.
+    static_assert(TAP_POOL_SIZE % 32 == 0, "freeTapSlots has one bit per pooled tap");
+    std::array<std::shared_ptr<MultiDlyTap<T, Ch>>, TAP_POOL_SIZE> tapPool;
+    std::array<std::atomic<uint32>, TAP_POOL_SIZE / 32> freeTapSlots;
+
+    // Loaded state is built into standbyTaps on the message thread, then handed to the audio thread, which swaps it
+    // with taps at the start of a chunk and runs both sets while it crossfades from the old one, in fadingTaps, to the
+    // new one. Both sets read and feed back into the same delay history, so the old taps' echoes carry on through the new ones.
+    // Adding and removing taps goes the same way: the edit is made to a copy of the active set, which the audio thread
+    // switches to without a fade, so nothing but the audio thread ever changes the set it runs.
+    enum StandbyState { StandbyEmpty, StandbyBuilding, StandbyReady, StandbySwapping };
+
+    TapSet standbyTaps; // only touched by whichever thread moved standbyState to StandbyBuilding or StandbySwapping
+    unsigned int standbyNumTaps = 0;
+    bool standbyCrossChannelFeedback = false;
+    bool standbyFades = true; // whether the standby set is a load to crossfade to, rather than an edit of the active set
+    std::atomic<int> standbyState { StandbyEmpty };
+
+    TapSet fadingTaps; // the set being faded out, audio thread only
+    int fadeLength = 0, fadePosition = 0; // in samples; a crossfade is running while fadePosition < fadeLength
+    std::atomic<double> crossfadeTimeMs { DEFAULT_CROSSFADE_MS };
+    HeapBlock<T> fadeGains; // each sample's gain for the outgoing then the incoming set, [set * blocksize + sample]
+
+    // the set the chunk's tap processing is running on, and the per-sample gain to apply to it, or nullptr for none
+    TapSet* runningTaps = &taps;
+    const T* runningGains = nullptr;
+
+    /// Claims the standby set for the message thread to build into, throwing away any set that is still waiting there to be swapped in.
+    void acquireStandby() noexcept;
+
+    /// Hands the standby set built since acquireStandby() to the audio thread.
+    void publishStandby(bool crossFeed) noexcept;
+
+    /// Takes a standby set that is waiting to be swapped in, returning false if there isn't one. Release it again with publishStandby().
+    bool holdReadyStandby() noexcept;
+
+    /**
+     Moves standbyState to StandbyBuilding from StandbyEmpty or StandbyReady, waiting out anything else, and returns the state it was taken from.
+
+     While it is held the audio thread can't swap sets, so both taps and standbyTaps can be read from the calling thread. Hand it back by storing the returned state.
+     */
+    int holdStandby() noexcept;
+
+    /// Releases one tap which the audio thread isn't running, handing its stages back, and its slot if it is pooled, and clears the pointer.
+    void releaseTap(std::shared_ptr<MultiDlyTap<T, Ch>>& a) noexcept;
+
+    /// Hands a tap's filter and compressor stages back to the arena.
+    void releaseStages(MultiDlyTap<T, Ch>& a) noexcept;
+
+    /// Releases the set a finished crossfade faded out, on the audio thread, without freeing anything. Only pooled taps are dropped; the rest are left for the message thread to reclaim.
+    void retireFadingTaps() noexcept;
+
+    /// Gets whether a tap is in the active set. Only safe while holding the standby, see holdStandby().
+    bool isInActiveSet(const std::shared_ptr<MultiDlyTap<T, Ch>>& a) const noexcept;
+
+    /// Empties the held standby set, handing back every tap in it that isn't also in the active set.
+    void reclaimStandby() noexcept;
+
+    /// Holds the standby for an edit: the set still waiting to be swapped in if there is one, otherwise a fresh copy of the active set. Finish with publishStandby().
+    void beginEdit() noexcept;
+
+    /// Removes a tap from the held standby set. It goes back to the pool at once if the audio thread isn't running it, or once an edit has swapped it out if it is.
+    void removeStandbyTap(int index) noexcept;
+
+    // the active set's taps by host slot, see MultiDlyTap::getHostSlot(). Audio thread only, rebuilt whenever the set changes.
+    std::array<MultiDlyTap<T, Ch>*, MAX_NUM_DLY_TAPS> tapsBySlot {};
+
+    /// Gives every tap in a set a distinct host slot, keeping the ones they already have where they can. See assignTapSlots().
+    static void assignSlots(TapSet& set) noexcept;
+
+    /// Rebuilds tapsBySlot from the active set.
+    void mapTapSlots() noexcept;
+
+    /// Swaps in a standby set if one is ready and no crossfade is running, and starts the crossfade to it. Audio thread only.
+    void beginCrossfade() noexcept;
+
+    // untimed changes from setTapParameter(), applied at the start of each block before any events
+    MultiDlyParameterTable<MAX_NUM_DLY_TAPS * numTapParameters> parameterTable;
+
+    // parameter events for the next block, sorted by sampleOffset. Audio thread only.
+    std::array<TapParameterEvent, MAX_PARAMETER_EVENTS_PER_BLOCK> pendingEvents;
+    int numPendingEvents = 0;
+
+    /// Applies an event to the active set's tap.
+    void applyParameterEvent(const TapParameterEvent& event) noexcept;
+
+    /// Runs a set of taps over the current chunk, scaled sample by sample by gains if it isn't nullptr. Only the active set is metered and profiled.
+    void processTapSet(TapSet& set, const T* gains);
+
+    /// Gets how much of the dry signal a set's taps keep between them: the average of (1 - mix) over the set, or 1 if it is empty.
+    T getDryShare(const TapSet& set) const noexcept;
+
+    // pooled taps keep their stages until they are next synced, so every one of them can be holding a pair at once
+    static_assert(STAGE_ARENA_SLOTS >= TAP_POOL_SIZE, "the stage arena must have a stage of each kind for every pooled tap");
+    MultiDlyStageArena<T, Ch> stageArena; // the filters and compressors taps borrow while those stages are enabled
+
+    static_assert(PROFILED_TAPS >= MAX_NUM_DLY_TAPS, "a TapCostSnapshot must have room for every tap");
+    bool profilingThisChunk = false; // one chunk in TAP_PROFILE_INTERVAL_CHUNKS is timed, when built with MULTIDLY_TAP_PROFILING
+    int64 chunkCounter = 0;
+
+   #if MULTIDLY_TAP_PROFILING
+    std::array<std::array<std::atomic<uint64>, TapCostSnapshot::NumStages>, MAX_NUM_DLY_TAPS> tapCycleTotals {}; // summed over the channel groups of the profiled chunk
+    TripleBuffer<TapCostSnapshot> tapCosts; // written by the audio thread, read by getLatestTapCosts()
+   #endif
+
+    // Levels are summed over a whole host block and published at its end. Each channel belongs to exactly one channel
+    // group, and each channel's tap levels have cache lines of their own, so groups running at once never share a line.
+    static_assert(METERED_TAPS >= MAX_NUM_DLY_TAPS && METERED_CHANNELS >= Ch, "a LevelSnapshot must have room for every tap and channel");
+
+    struct alignas(CACHE_LINE_SIZE) ChannelTapLevels
+    {
+        std::array<float, MAX_NUM_DLY_TAPS> peaks {}, sumsOfSquares {}; // [tap]
+    };
+
+    std::array<ChannelTapLevels, Ch> tapLevels {}; // [chan]
+    std::array<float, Ch> inputPeaks {}, inputSumsOfSquares {}, outputPeaks {}, outputSumsOfSquares {};
+    int meteredSamples = 0;
+    int64 blockCounter = 0;
+    TripleBuffer<LevelSnapshot> levels; // written by the audio thread, read by getLatestLevels()
+
+    /// Publishes the block's levels and clears the accumulators for the next one.
+    void publishLevels() noexcept;
+
+    /// Adds one channel group's stage timings to tapCycleTotals. Safe to call from several groups at once.
+    void mergeTapCosts(const TapStageTimer& timer) noexcept;
+
+    /// Publishes the profiled chunk's costs and clears the totals for the next one.
+    void publishTapCosts(int numSamples) noexcept;
+
+    /// Claims a free slot of tapPool without locking or allocating, returning its index or -1 if the pool is exhausted.
+    int claimTapSlot() noexcept;
+
+    /// Hands a slot claimed by claimTapSlot() back to the pool.
+    void releaseTapSlot(int slot) noexcept;
+
+    /// Claims and resets a pooled tap without adding it to any set, returning nullptr if there are none left.
+    std::shared_ptr<MultiDlyTap<T, Ch>> claimPooledTap() noexcept;
+
+    double sr = 0.0;
+    int blocksize = 0;
 
     const int numChannels;
 
+    juce::SharedResourcePointer<MultiDlyWorkerPool> workerPool; // shared by every engine in the process
+    int64 callbackDeadlineTicks = 0; // when the current callback's realtime budget runs out, in high resolution ticks
+
+    bool crossChannelFeedback = false; // when set, each channel's feedback is written to the next channel instead of itself
+
 
 
 //    std::array<T, MAX_DELAY_TIME_SECONDS * 48000> data;
 
-    AudioBuffer<T> data;
+    // In the planar layout every channel starts on its own cache line, so channel groups running on different workers
+    // never write to the same line. The interleaved layout can't promise that, so it is always processed serially.
+    MultiDlyDelayBuffer<T, Ch> data;
 
     unsigned int writeidx = 0; // the index of data that incoming audio is written to
 
+    static_assert(HISTORY_MAX_MARKERS >= MAX_NUM_DLY_TAPS, "the history needs a marker for every tap");
+    MultiDlyHistoryPyramid history { DELAY_BUFFER_LENGTH }; // summarises each chunk of data once the taps have finished with it
+
+    /// Adds the chunk just processed, which starts at writeidx, to history, and moves the tap markers to where the taps read from.
+    void updateHistory(int numSamples) noexcept;
+
+    static_assert(DISPLAY_STATE_MAX_TAPS == MAX_NUM_DLY_TAPS, "the display state is published straight from taps");
+    std::shared_ptr<MultiDlyDisplayStateManager<T, Ch>> displayState; // published to at the end of every block
+    std::atomic<int64> totalSamplesWritten { 0 }; // like writeidx but never wraps, so the prefault target stops at the end of the first lap. Written by the audio thread only.
+
+    // How much history was behind the write index at the start of the chunk. During the first lap, anything older is
+    // read as silence without touching the buffer, as prefaulting only runs ahead of the write index, so a long tap's
+    // window can fall on pages which haven't been committed yet.
+    int writtenHistory = 0;
+
+    /// Reads numSamples of one channel's history, starting offset samples behind the write index, into dest, reading anything from before writtenHistory as silence.
+    void readHistoryWindow(int chan, int offset, T* dest, int numSamples) noexcept;
+
+    // per-block scratch, sized by setBlockSize()
+    HeapBlock<char> wetBusMemory;
+    T* wetBus = nullptr; // every tap's output for the chunk, [chan * wetBusStride + sample], added to the block in one pass at the end
+    int wetBusStride = 0; // blocksize rounded up to whole cache lines, so channel groups on different workers never share a line
+    T* chunkHistory = nullptr; // what the chunk writes to the buffer, input plus feedback, [chan * wetBusStride + sample], stored in one block per tap set. In wetBusMemory after the wet bus.
+    T* tapWet = nullptr; // each of the active set's per-sample taps' wet output for the chunk, kept to be metered in one pass, [(tap * Ch + chan) * wetBusStride + sample]. In wetBusMemory after chunkHistory.
+    HeapBlock<T> tapWindows; // compact formats only: each per-sample tap's window of older history, converted in one block, [(tap * Ch + chan) * blocksize + sample]
+    HeapBlock<int> tapOffsets; // the write index offset of each tap for each sample of the block, [tap * blocksize + sample]
+    HeapBlock<T> staticTapWindow; // where a static tap's window is converted to when the buffer can't be read in place, [chan * blocksize + sample]
+
+    // taps which are static (see MultiDlyTap::isStatic()) for the current chunk, and so are run by processStaticTaps()
+    std::array<bool, MAX_NUM_DLY_TAPS> tapIsStatic {};
+    std::array<int, MAX_NUM_DLY_TAPS> staticTapIndices {};
+    int numStaticTaps = 0;
+    int numDynamicTaps = 0; // the rest of the running set's taps, which processChannelGroup() runs sample by sample
+
+    bool inputWritten = false; // whether the chunk's input is in the buffer yet. The first tap set to run writes it, along with its feedback.
+
+    // A dense set of static taps is rendered into an impulse response on the background thread and convolved, so that
+    // its cost no longer depends on the number of taps. Only float engines do this, as juce::dsp::Convolution is float only.
+    struct StaticTapSpec
+    {
+        int numTaps = 0;
+        std::array<int, MAX_NUM_DLY_TAPS> offsets {};
+        std::array<T, MAX_NUM_DLY_TAPS> mixes {};
+        uint32 id = 0; // which request this is, never zero
+    };
+
+    StaticTapSpec requestedSpec; // written by the audio thread, copied by the background thread, guarded by requestedSpecVersion
+    std::atomic<uint32> requestedSpecVersion { 0 }; // odd while requestedSpec is being written
+    uint32 staticTapSignature = 0; // the signature of the static taps the convolvers are being fed for, or 0 if they aren't being fed, audio thread only
+    uint32 staticTapResponseId = 0; // the id of the request for those taps' impulse response, audio thread only
+    uint32 numStaticTapRequests = 0; // audio thread only
+    std::atomic<uint64> loadedResponse { 0 }; // the id of the impulse response most recently handed to the convolvers in the top 32 bits, and its length in the bottom 32
+    std::atomic<uint32> confirmedResponseId { 0 }; // the id of the newest impulse response the audio thread has seen every convolver running
+    std::array<std::atomic<int>, Ch> runningResponseLengths {}; // the length of the impulse response each convolver was running at the start of the chunk, published by the audio thread
+    uint32 builtResponseId = 0; // background thread only
+    Array<int> unconfirmedLengths; // the lengths of the impulse responses handed to the convolvers since the newest was confirmed, background thread only
+    int convolutionWarmup = -1; // how many more samples the convolvers need to be fed before their output is complete, or -1 until they are running the current response, audio thread only
+    int convolutionFade = 0; // how far the output is through its crossfade from the sparse FIR to the convolvers, out of blocksize samples, audio thread only
+    bool feedConvolvers = false; // decided each chunk
+    double convolutionGain = 0.0; // the convolvers' share of the static taps' output at the chunk's first sample
+    double convolutionGainStep = 0.0; // how much that share grows each sample of the chunk
+    HeapBlock<T> convolutionWindows; // each channel's convolver output for the chunk, followed by its sparse FIR output while the two are crossfaded, [(chan * 2 + which) * blocksize + sample]
+
+    juce::SharedResourcePointer<dsp::ConvolutionMessageQueue> convolutionQueue; // the thread juce::dsp::Convolution swaps impulse responses on
+    OwnedArray<dsp::Convolution> staticConvolvers; // one per channel
+    juce::SharedResourcePointer<MultiDlyBackgroundThread> backgroundThread;
+
+   #if MULTIDLY_TRACING
+    juce::SharedResourcePointer<MultiDlyTracer> tracer; // keeps the process's tracer alive while there are engines
+   #endif
+
+    /// Gets a hash of the static taps' offsets and mixes, which is never zero. Must be called after computeTapOffsets().
+    uint32 computeStaticTapSignature() const;
+
+    /// Publishes the current static taps for the background thread to render. Never allocates or blocks.
+    void requestStaticTapImpulseResponse();
+
+    /**
+     Decides, once per chunk, whether the convolvers are fed and how much of the static taps' output comes from them rather than the sparse FIR. Must be called after computeTapOffsets().
+
+     A new impulse response is swapped in by juce::dsp::Convolution on its own thread some time after it is loaded, into an engine with no history, so the convolvers' output is only used once every one of them is seen running it (see useTimeSlice()) and has since been fed its whole length, plus the time Convolution takes crossfading to it. The output is then crossfaded from the FIR to the convolvers over a block.
+     */
+    void updateStaticTapConvolution();
+
+    /// TimeSliceClient callback, which resamples the history after a rate change, then builds and loads the impulse response for the most recently requested static taps.
+    int useTimeSlice() override;
+
+    // After a sample rate change the old history is copied out, the buffer is cleared, and the background thread writes
+    // the history back at the new rate, newest first, behind the write index the audio thread carries on from.
+    MultiDlyHistoryResampler historyResampler;
+    HeapBlock<T> resampleSource; // the history at the old rate, oldest first, [chan * resampleSourceLength + sample]
+    int resampleSourceLength = 0;
+    double resampleSourceRate = 0.0; // the rate resampleSource was recorded at
+    int resampleLength = 0; // how many samples the history is at the new rate
+    int resampleDone = 0; // how many of those have been written so far
+    int resampleEndIndex = 0; // the write index when the rate changed, which the newest resampled sample goes just before
+    int64 resampleStartSamplesWritten = 0; // totalSamplesWritten when the rate changed
+    std::array<uint32, Ch> resampleDither {}; // the background thread's own dither generators, for a 16-bit buffer
+    HeapBlock<T> resampleScratch; // RESAMPLE_CHUNK_SAMPLES
+    bool resampling = false; // only changed by the background thread, or while it has been kept off this engine
+
+    /**
+     Starts converting the history, recorded at oldRate, to the current rate. Must be called from prepareToPlay(), after the new rate has been set.
+
+     Only the copy and the clear happen here, so the message thread is held up for milliseconds, not for the whole conversion. Until the background thread has written a stretch of history back, taps reading it hear silence rather than audio at the wrong pitch.
+     */
+    void startHistoryResample(double oldRate);
+
+    /// Resamples the next chunk of history into the buffer, or finishes the resample if there's nothing left that the audio thread hasn't already overwritten.
+    int resampleHistoryChunk();
+
+    // the chunk currently being processed, used by processChannelGroupTask()
+    AudioBuffer<T>* currentSamples = nullptr;
+    int currentStartSample = 0, currentNumSamples = 0, currentGroupSize = Ch;
+
+    /// Processes a chunk of at most blocksize samples, starting at startSample in samples.
+    void processChunk(AudioBuffer<T>& samples, int startSample, int numSamples);
+
+    /// Fills tapOffsets for the next numSamples, advancing each tap's smoothed time exactly once per sample. Static taps only get their first entry filled, as it can't change.
+    void computeTapOffsets(int numSamples);
+
+    /**
+     Adds the output of every static tap to channels [firstChan, lastChan) of the wet bus.
+
+     Together these taps are a sparse FIR over the delay history, so each one is a single multiply-accumulate of a contiguous window of history into the output. This must run after the per-sample taps, because a static tap shorter than the chunk reads history those taps' feedback has just been added to.
+
+     With CONVOLUTION_MIN_STATIC_TAPS or more static taps, the chunk's history is also run through each channel's convolver, and updateStaticTapConvolution() decides how much of the output is taken from them. Until they are ready, the sparse FIR is still used for the output, while the convolvers keep being fed so that their history is complete when they take over.
+
+     Each tap's time is charged to the calling group's timer, with the convolution split evenly between the static taps.
+     */
+    void processStaticTaps(int firstChan, int lastChan, TapStageTimer& timer);
+
+    /**
+     Runs every tap on channels [firstChan, lastChan) of the current chunk, sample by sample, into the wet bus.
+
+     The input plus every tap's feedback is summed into chunkHistory, which taps shorter than the chunk read from, and goes into the delay buffer as one block at the end, so the compact formats convert it with their vectorised paths and round (and dither) it once. In those formats, taps whose time isn't moving have their windows of older history converted in one block too. The block itself is only read here, as the input; it is scaled to the taps' share of the dry signal and the wet bus is added to it once every tap set has run.
+     */
+    void processChannelGroup(int firstChan, int lastChan);
+
+    /// MultiDlyWorkerPool task, which processes one group of currentGroupSize channels.
+    static void processChannelGroupTask(void* engine, int groupIndex);
+
 public:
 
 
@@ -58,13 +490,15 @@ public:
      @brief The only valid constructor for MultiDlyEngine.
      @param sampleRate The sampling rate for the engine in Hz.
      @param blockSize The number of audio samples to expect per block.
+     @param layout The memory layout of the delay buffer. Interleaved suits many taps spread over long times on a few channels; planar allows channel groups to run in parallel.
+     @param format The format the delay history is stored in. The compact formats halve the buffer's memory and read bandwidth; see DelayBufferFormat for what they cost in quality.
      */
-    MultiDlyEngine(double sampleRate, int blockSize);
+    MultiDlyEngine(double sampleRate, int blockSize, DelayBufferLayout layout = DelayBufferLayout::Planar, DelayBufferFormat format = DelayBufferFormat::Native);
 
     /**
      @brief Destructor.
      */
-    ~MultiDlyEngine();
+    ~MultiDlyEngine() override;
 
     double smoothingRampLength = 0.1;
 
@@ -79,10 +513,43 @@ public:
 
      Called before playback in order to set Sampling Rate and Block Size. This is not necessarily called before each playback, but is always called before the first callback to processSamples().
 
+     If the sampling rate has changed, the delay history is resampled to the new rate on the background thread, so the tails carry on at the right pitch and timing; see startHistoryResample().
+
      @param sr The sampling rate to play back at, in Hz.
      @param block_size The expected block size, in samples.
      */
-    void prepareToPlay(double sr, int block_size);
+    void prepareToPlay(double sr, int block_size) override;
+
+    /**
+     @brief EngineBase callback, which notes the callback's deadline and calls processSamples().
+
+     @param samples The buffer from the host.
+     */
+    void processBlock(AudioBuffer<float>& samples) override;
+
+    /// @brief Gets the number of channels, which is always Ch.
+    int getNumChannels() const override { return numChannels; }
+
+    /// @brief See EngineBase::getLatestTapCosts().
+    bool getLatestTapCosts(TapCostSnapshot& dest) override;
+
+    /// @brief See EngineBase::getLatestLevels().
+    bool getLatestLevels(LevelSnapshot& dest) override;
+
+    /// @brief See EngineBase::getHistory().
+    const MultiDlyHistoryPyramid& getHistory() const override { return history; }
+
+    /// @brief See EngineBase::getDisplayStateManager().
+    std::shared_ptr<MultiDlyDisplayStateManagerBase> getDisplayStateManager() const override { return displayState; }
+
+    /// @brief See EngineBase::getNumStageAcquireFailures().
+    uint32 getNumStageAcquireFailures() const override { return stageArena.getNumFailedAcquires(); }
+
+    /// @brief Gets the memory layout of the delay buffer, chosen at construction.
+    DelayBufferLayout getDelayBufferLayout() const { return data.getLayout(); }
+
+    /// @brief Gets the storage format of the delay buffer, chosen at construction.
+    DelayBufferFormat getDelayBufferFormat() const { return data.getFormat(); }
 
     /**
      @brief Main callback for processing samples
@@ -95,17 +562,63 @@ public:
     /**
      Attempts to add a MultiDlyTap to the engine, returning true if the tap is successfully added and false if it is unsuccessful.
 
+     Like every edit to the set of taps, this is made to a copy of the set, which the audio thread switches to at the start of its next chunk, and can be called while audio is running from any thread but the audio thread. Until then getTap() and getState() already show the change.
+
      @param tapToAdd The shared_ptr to the tap that should be added. It is not necessary for the owner to continue to own their copy of tapToAdd after this callback completes.
      @param delayBufferSize The size, in samples, of the delay buffer. This is currently defined internally to the engine, so callers may leave it as zero so that the engine can fill in the correct value.
      */
     bool addDelayTap(std::shared_ptr<MultiDlyTap<T, Ch>> tapToAdd, unsigned int delayBufferSize = 0);
 
-    // creates a MultiDlyTap from a ValueTree of the tap's parameters, returning the tap if and only if the tap is successfully created and its parameters filled, and the tap is successfully added to the engine through a call to addDelayTap(). If either of these steps is unsuccessful, this function should return nullptr.
+    /**
+     Creates a MultiDlyTap from a ValueTree of the tap's parameters and adds it to the engine, returning the tap, or nullptr if every tap is already in use.
+
+     The tap comes from the engine's preallocated pool, so this never allocates, and it is added as addDelayTap() adds a tap. Once the tap is removed with removeTap() its slot is recycled, so callers must not keep using a tap after removing it.
+
+     @param delayTapParametersVT The tap's parameters, as created by MultiDlyTap::toVT().
+     @param delayBufferSize Unused, as pooled taps are always created for the engine's own delay buffer. Kept for compatibility.
+     */
     std::shared_ptr<MultiDlyTap<T, Ch>> createAndAddDelayTap(ValueTree delayTapParametersVT, unsigned int delayBufferSize = 0);
 
+    /**
+     Creates a MultiDlyTap from a binary state record and adds it to the engine, returning the tap, or nullptr if every tap is already in use. The same as the `ValueTree` version in every other respect.
+
+     @param record The tap's parameters, as written by MultiDlyTap::toRecord().
+     */
+    std::shared_ptr<MultiDlyTap<T, Ch>> createAndAddDelayTap(const TapRecord& record);
+
+    /// @brief See EngineBase::addTapAt().
+    int addTapAt(double timeMs) override;
+
+    /// @brief See EngineBase::removeTapInSlot().
+    void removeTapInSlot(int slot) override;
+
+    /// @brief See EngineBase::getState().
+    void getState(MemoryBlock& dest) override;
+
+    /// @brief See EngineBase::setState().
+    bool setState(const void* data, size_t sizeInBytes) override;
+
+    /// @brief See EngineBase::getStateAsValueTree().
+    ValueTree getStateAsValueTree() override;
+
+    /// @brief See EngineBase::setStateFromValueTree().
+    void setStateFromValueTree(const ValueTree& state) override;
+
+    /// @brief See EngineBase::setCrossfadeTimeMs().
+    void setCrossfadeTimeMs(double newCrossfadeMs) override { crossfadeTimeMs.store(jmax(0.0, newCrossfadeMs)); }
+
+    /// @brief See EngineBase::getCrossfadeTimeMs().
+    double getCrossfadeTimeMs() const override { return crossfadeTimeMs.load(); }
+
+    /// @brief See EngineBase::queueParameterEvent().
+    void queueParameterEvent(const TapParameterEvent& event) override;
+
+    /// @brief See EngineBase::setTapParameter().
+    void setTapParameter(int tap, TapParameter parameter, float value) override;
+
 
     /**
-     @brief Sets the sample rate for the engine and all its taps.
+     @brief Sets the sample rate for the engine and all its taps, including the free ones in the pool. Taps keep their parameters.
 
      @param newSampleRate The new sampling rate in Hz.
      */
@@ -114,13 +627,26 @@ public:
     /**
      @brief Sets the block size for processing.
 
-     At this point the taps don't actually care about the block size, but at some point, sub-block processing should be implemented here so that the effects in each tap don't have to process single samples. This is probably more efficient and certainly allows for more chance of SIMD optimization, from JUCE, the compiler, or us.
+     This allocates the per-block scratch buffers, so must not be called during playback. processSamples() splits any block longer than this into chunks.
 
      @param newBlockSize The new block size for processing.
      */
     void setBlockSize(int newBlockSize);
 
 
+    /**
+     @brief Sets whether each channel's feedback should be routed into the next channel (wrapping around) rather than into itself.
+
+     Cross-channel feedback makes every channel depend on every other one sample by sample, so while it is enabled the engine always processes serially. The change is handed to the audio thread as an edit of the set of taps is, see addDelayTap().
+
+     @param shouldCrossFeed The new value for whether feedback crosses channels.
+     */
+    void setCrossChannelFeedback(bool shouldCrossFeed);
+
+    /// @brief Gets whether feedback crosses channels, including a change that hasn't been swapped in yet.
+    bool getCrossChannelFeedback();
+
+
     /**
      @brief Returns the current sample rate.
      */
@@ -131,19 +657,25 @@ public:
     //! writes new audio from host to circular buffer
 
     /**
-     @brief Writes new audio data to the circular buffer for delay processing.
+     @brief Writes new audio data to the circular buffer for delay processing, overwriting the oldest history.
 
      This is currently public, but it should probably only be used internally. Until I know for sure there is no good reason to do this from the outside, I'll leave it public.
 
      This function doesn't actually iterate the write index, because offsets for delay length need to be calculated from the write index's location relative to the current sample, not the sample `data.length()` ahead. The write index is iterated by processSamples().
 
-     @param data The data to add to the delay buffer.
+     @param incomingAudio The data to add to the delay buffer.
+     @param startSample The first sample of incomingAudio to write.
+     @param numSamples The number of samples to write. Must be less than the length of the delay buffer.
+     @param firstChan The first channel to write.
+     @param lastChan One past the last channel to write.
      */
-    void writeIncomingAudio(juce::AudioBuffer<float>& data);
+    void writeIncomingAudio(const juce::AudioBuffer<T>& incomingAudio, int startSample, int numSamples, int firstChan = 0, int lastChan = Ch);
 
 
     /**
-     @brief removes a tap from the sorted array.
+     @brief removes a tap from the sorted array, as getTap() indexes it.
+
+     The edit is handed to the audio thread as addDelayTap()'s are. If the tap came from the pool, its slot is freed for createAndAddDelayTap() to reuse, but not until the audio thread has stopped running it.
      */
     void removeTap(int index);
 
@@ -155,9 +687,63 @@ public:
     void removeTap(std::shared_ptr<MultiDlyTap<T, Ch>> tap);
 
     /**
-     @brief Gets a shared_ptr to the tap at index.
+     @brief Gets a shared_ptr to the tap at index of the newest set, including any edit or load the audio thread hasn't switched to yet, or nullptr if there isn't one.
      @param index The index to fetch a tap from.
      */
     std::shared_ptr<MultiDlyTap<T, Ch>> getTap(int index);
 
+    /**
+     @brief Decides whether this callback has enough work to be worth spreading over the shared MultiDlyWorkerPool.
+
+     Engines with few taps, few channels or small blocks opt out, and so does every engine once the process has more instances than cores.
+
+     @param numTasks The number of tasks the callback would be split into.
+     */
+    bool shouldUseWorkerPool(int numTasks) const;
+
+    /**
+     @brief Gets the number of channel groups a parallel callback is split into.
+
+     Each group is a run of adjacent channels, so it touches a contiguous set of delay buffer channels and filter states.
+     */
+    int getNumChannelGroups() const;
+
 };
+
+
+/**
+ @brief Creates an engine for a given number of channels, returning nullptr if there is no engine for that channel count.
+
+ @tparam T The type to perform audio processing with
+ @param numChannels The number of input and output channels.
+ @param sampleRate The sampling rate for the engine in Hz.
+ @param blockSize The number of audio samples to expect per block.
+ @param layout The memory layout of the engine's delay buffer.
+ @param format The storage format of the engine's delay buffer.
+ */
+template <class T>
+std::shared_ptr<EngineBase> createMultiDlyEngine(int numChannels, double sampleRate, int blockSize, DelayBufferLayout layout = DelayBufferLayout::Planar, DelayBufferFormat format = DelayBufferFormat::Native);
+
+
+#if MULTIDLY_LAYOUT_BENCHMARK
+/**
+ @brief Times the planar and interleaved delay buffer layouts at 2, 6 and 12 channels, returning a report.
+
+ Each engine runs MAX_NUM_DLY_TAPS / 4 filtered taps, so every tap goes through the per-sample path where the layouts differ, for LAYOUT_BENCHMARK_BLOCKS blocks of noise. Channel groups can use the worker pool in the planar layout, as they would in the plugin. Only built into the MultiDlyTests console app, which runs this with `--layout-benchmark`.
+ */
+String runLayoutBenchmark();
+#endif
+
+
+#if MULTIDLY_REALTIME_SELF_TEST
+/**
+ @brief Runs engines through everything the audio thread does with MultiDlyRealtimeChecks set to abort on a violation, returning a report if nothing was found.
+
+ Each engine is processed inside a realtime scope, for REALTIME_SELF_TEST_BLOCKS blocks per phase, in every delay buffer format at 2 and 6 channels:
+ filtered and compressed taps borrowing stages, timed and untimed parameter changes, a state load crossfading to a dense set of static taps that gets convolved, and a sample rate change resampling the history.
+ Anything which allocates, locks or sleeps on the audio thread, or on a worker running part of its callback, aborts the process with a stack trace.
+
+ Only built into the MultiDlyTests console app, which has MULTIDLY_REALTIME_CHECKS on and runs this for CTest with `--realtime-self-test`.
+ */
+String runRealtimeSelfTest();
+#endif